@@ -0,0 +1,306 @@
+// End-to-end benchmarks: runs every program in benchmarks/mist through the
+// misty binary, in the VM and the tree walker, and reports the wall time
+// of each. Each program first runs --warmup times, the first of which must
+// print what its .out file holds, then --runs times measured. The median
+// and the 95th percentile go to stdout as a table and, with --json, to a
+// file that later runs can be compared against.
+//
+// Build and run from the repository root:
+//   make bench
+// or by hand:
+//   g++ -std=c++17 -O2 benchmarks/bench.cpp -o build/bench
+//   build/bench --misty build/misty --json bench.json
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <spawn.h>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+extern char** environ;
+
+struct Options {
+    std::string misty = "build/misty";
+    std::string label = "";
+    std::string json_path = "";
+    std::vector<std::string> engines = { "vm", "tree-walk" };
+    std::vector<std::string> programs;
+    int warmup = 1;
+    int runs = 10;
+};
+
+struct Result {
+    std::string name;
+    std::string engine;
+    std::vector<double> samples_ms;
+    double median_ms;
+    double p95_ms;
+};
+
+static const char* default_programs[] = {
+    "benchmarks/mist/fib.mist",
+    "benchmarks/mist/loops.mist",
+    "benchmarks/mist/strings.mist",
+    "benchmarks/mist/arrays.mist",
+    "benchmarks/mist/members.mist",
+    "benchmarks/mist/imports.mist",
+};
+
+static void usage() {
+    std::cerr << "Usage: bench [--misty <path>] [--warmup <n>] [--runs <n>] [--engine vm|tree-walk|both]" << std::endl;
+    std::cerr << "             [--json <file>] [--label <name>] [program.mist ...]" << std::endl;
+    exit(2);
+}
+
+static std::string file_name(std::string path) {
+    size_t slash = path.find_last_of('/');
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    return name.substr(0, name.rfind(".mist"));
+}
+
+static std::string read_file(std::string path) {
+    std::ifstream input(path);
+    std::stringstream text;
+
+    text << input.rdbuf();
+    return text.str();
+}
+
+// Runs the program once and returns how long it took, in milliseconds.
+// Its output goes to capture, or nowhere when capture is empty. Negative
+// if it could not be run or did not exit cleanly.
+static double run(Options& options, std::string engine, std::string program, std::string capture) {
+    std::vector<std::string> args = { options.misty };
+
+    if(engine == "tree-walk") {
+        args.push_back("--tree-walk");
+    }
+    args.push_back(program);
+
+    std::vector<char*> argv;
+
+    for(std::string& arg : args) {
+        argv.push_back((char*) arg.c_str());
+    }
+    argv.push_back(NULL);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, capture.empty() ? "/dev/null" : capture.c_str(),
+                                     O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid;
+    int status;
+
+    if(posix_spawn(&pid, argv[0], &actions, NULL, argv.data(), environ) != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        return -1;
+    }
+
+    waitpid(pid, &status, 0);
+    auto end = std::chrono::steady_clock::now();
+    posix_spawn_file_actions_destroy(&actions);
+
+    if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return -1;
+    }
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Nearest rank: the smallest sample at least p percent of them do not exceed.
+static double percentile(std::vector<double> sorted, double p) {
+    size_t rank = (size_t) std::ceil(p / 100.0 * sorted.size());
+    return sorted[std::max(rank, (size_t) 1) - 1];
+}
+
+static double median(std::vector<double> sorted) {
+    size_t middle = sorted.size() / 2;
+    return sorted.size() % 2 == 1 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+}
+
+static bool measure(Options& options, std::string engine, std::string program, Result& result) {
+    result.name = file_name(program);
+    result.engine = engine;
+
+    std::string expected_path = program.substr(0, program.rfind(".mist")) + ".out";
+    std::string capture = "/tmp/misty_bench_" + std::to_string(getpid()) + ".out";
+
+    for(int i = 0; i < options.warmup; i++) {
+        bool check = i == 0 && access(expected_path.c_str(), R_OK) == 0;
+
+        if(run(options, engine, program, check ? capture : "") < 0) {
+            std::cerr << "bench: " << program << " failed (" << engine << ")" << std::endl;
+            return false;
+        }
+
+        if(check && read_file(capture) != read_file(expected_path)) {
+            std::cerr << "bench: " << program << " printed something other than " << expected_path
+                      << " (" << engine << ")" << std::endl;
+            unlink(capture.c_str());
+            return false;
+        }
+        unlink(capture.c_str());
+    }
+
+    for(int i = 0; i < options.runs; i++) {
+        double ms = run(options, engine, program, "");
+
+        if(ms < 0) {
+            std::cerr << "bench: " << program << " failed (" << engine << ")" << std::endl;
+            return false;
+        }
+        result.samples_ms.push_back(ms);
+    }
+
+    std::vector<double> sorted = result.samples_ms;
+    std::sort(sorted.begin(), sorted.end());
+
+    result.median_ms = median(sorted);
+    result.p95_ms = percentile(sorted, 95);
+    return true;
+}
+
+static std::string json_string(std::string text) {
+    std::string quoted = "\"";
+
+    for(char c : text) {
+        if(c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+static void write_json(Options& options, std::vector<Result>& results) {
+    std::ofstream json(options.json_path);
+    char number[32];
+
+    json << "{\n";
+    json << "  \"label\": " << json_string(options.label) << ",\n";
+    json << "  \"misty\": " << json_string(options.misty) << ",\n";
+    json << "  \"timestamp\": " << std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count() << ",\n";
+    json << "  \"warmup\": " << options.warmup << ",\n";
+    json << "  \"runs\": " << options.runs << ",\n";
+    json << "  \"results\": [\n";
+
+    for(size_t i = 0; i < results.size(); i++) {
+        Result& result = results[i];
+        auto [min, max] = std::minmax_element(result.samples_ms.begin(), result.samples_ms.end());
+
+        json << "    { \"name\": " << json_string(result.name) << ", \"engine\": " << json_string(result.engine);
+
+        snprintf(number, sizeof(number), "%.3f", result.median_ms);
+        json << ", \"median_ms\": " << number;
+        snprintf(number, sizeof(number), "%.3f", result.p95_ms);
+        json << ", \"p95_ms\": " << number;
+        snprintf(number, sizeof(number), "%.3f", *min);
+        json << ", \"min_ms\": " << number;
+        snprintf(number, sizeof(number), "%.3f", *max);
+        json << ", \"max_ms\": " << number << ",\n      \"samples_ms\": [";
+
+        for(size_t j = 0; j < result.samples_ms.size(); j++) {
+            snprintf(number, sizeof(number), "%.3f", result.samples_ms[j]);
+            json << (j > 0 ? ", " : "") << number;
+        }
+        json << "] }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+
+    json << "  ]\n";
+    json << "}\n";
+}
+
+static int parse_count(std::string value) {
+    int count = atoi(value.c_str());
+
+    if(count < 0 || value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+        usage();
+    }
+    return count;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if(arg.rfind("--", 0) == 0 && i + 1 >= argc) {
+            usage();
+        }
+
+        if(arg == "--misty") {
+            options.misty = argv[++i];
+        } else if(arg == "--warmup") {
+            options.warmup = parse_count(argv[++i]);
+        } else if(arg == "--runs") {
+            options.runs = parse_count(argv[++i]);
+        } else if(arg == "--json") {
+            options.json_path = argv[++i];
+        } else if(arg == "--label") {
+            options.label = argv[++i];
+        } else if(arg == "--engine") {
+            std::string engine = argv[++i];
+
+            if(engine == "both") {
+                options.engines = { "vm", "tree-walk" };
+            } else if(engine == "vm" || engine == "tree-walk") {
+                options.engines = { engine };
+            } else {
+                usage();
+            }
+        } else if(arg.rfind("--", 0) == 0) {
+            usage();
+        } else {
+            options.programs.push_back(arg);
+        }
+    }
+
+    if(options.runs == 0) {
+        usage();
+    }
+
+    if(options.programs.empty()) {
+        options.programs.assign(std::begin(default_programs), std::end(default_programs));
+    }
+
+    std::vector<Result> results;
+    bool failed = false;
+    char row[128];
+
+    snprintf(row, sizeof(row), "%-12s %-10s %12s %12s", "benchmark", "engine", "median ms", "p95 ms");
+    std::cout << row << std::endl;
+
+    for(std::string& program : options.programs) {
+        for(std::string& engine : options.engines) {
+            Result result;
+
+            if(!measure(options, engine, program, result)) {
+                failed = true;
+                continue;
+            }
+
+            snprintf(row, sizeof(row), "%-12s %-10s %12.1f %12.1f", result.name.c_str(), engine.c_str(),
+                     result.median_ms, result.p95_ms);
+            std::cout << row << std::endl;
+            results.push_back(result);
+        }
+    }
+
+    if(!options.json_path.empty()) {
+        write_json(options, results);
+        std::cout << "Results written to " << options.json_path << std::endl;
+    }
+    return failed ? 1 : 0;
+}
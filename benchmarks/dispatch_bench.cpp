@@ -0,0 +1,192 @@
+// Microbenchmark for AST node dispatch: the dynamic_cast chain the visitors
+// used to run on every node versus the switch over AST::kind.
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 benchmarks/dispatch_bench.cpp parser/AST.cpp lexer/Token.cpp -o dispatch_bench
+//   ./dispatch_bench
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include "../parser/AST.h"
+
+static long counter = 0;
+
+__attribute__((noinline)) static void handle(AST* node, int branch) {
+    counter += branch;
+}
+
+static void dispatch_dynamic_cast(AST* node) {
+    if(BinaryOperator* ast = dynamic_cast<BinaryOperator*>(node)) {
+        handle(ast, 1);
+    } else if(UnaryOperator* ast = dynamic_cast<UnaryOperator*>(node)) {
+        handle(ast, 2);
+    } else if(Value* ast = dynamic_cast<Value*>(node)) {
+        handle(ast, 3);
+    } else if(Compare* ast = dynamic_cast<Compare*>(node)) {
+        handle(ast, 4);
+    } else if(Compound* ast = dynamic_cast<Compound*>(node)) {
+        handle(ast, 5);
+    } else if(Assign* ast = dynamic_cast<Assign*>(node)) {
+        handle(ast, 6);
+    } else if(Variable* ast = dynamic_cast<Variable*>(node)) {
+        handle(ast, 7);
+    } else if(NoOperator* ast = dynamic_cast<NoOperator*>(node)) {
+        handle(ast, 8);
+    } else if(DoubleCondition* ast = dynamic_cast<DoubleCondition*>(node)) {
+        handle(ast, 9);
+    } else if(Negation* ast = dynamic_cast<Negation*>(node)) {
+        handle(ast, 10);
+    } else if(VariableDeclaration* ast = dynamic_cast<VariableDeclaration*>(node)) {
+        handle(ast, 11);
+    } else if(IfCondition* ast = dynamic_cast<IfCondition*>(node)) {
+        handle(ast, 12);
+    } else if(Print* ast = dynamic_cast<Print*>(node)) {
+        handle(ast, 13);
+    } else if(ArrayInit* ast = dynamic_cast<ArrayInit*>(node)) {
+        handle(ast, 14);
+    } else if(ArrayAccess* ast = dynamic_cast<ArrayAccess*>(node)) {
+        handle(ast, 15);
+    } else if(FunctionInit* ast = dynamic_cast<FunctionInit*>(node)) {
+        handle(ast, 16);
+    } else if(FunctionCall* ast = dynamic_cast<FunctionCall*>(node)) {
+        handle(ast, 17);
+    } else if(Return* ast = dynamic_cast<Return*>(node)) {
+        handle(ast, 18);
+    } else if(WhileLoop* ast = dynamic_cast<WhileLoop*>(node)) {
+        handle(ast, 19);
+    } else if(CastValue* ast = dynamic_cast<CastValue*>(node)) {
+        handle(ast, 20);
+    } else if(Import* ast = dynamic_cast<Import*>(node)) {
+        handle(ast, 21);
+    } else if(ObjectDive* ast = dynamic_cast<ObjectDive*>(node)) {
+        handle(ast, 22);
+    }
+}
+
+static void dispatch_kind(AST* node) {
+    switch(node->kind) {
+        case NodeKind::BINARY_OPERATOR:
+            handle(node, 1);
+            break;
+        case NodeKind::UNARY_OPERATOR:
+            handle(node, 2);
+            break;
+        case NodeKind::VALUE:
+            handle(node, 3);
+            break;
+        case NodeKind::COMPARE:
+            handle(node, 4);
+            break;
+        case NodeKind::COMPOUND:
+            handle(node, 5);
+            break;
+        case NodeKind::ASSIGN:
+            handle(node, 6);
+            break;
+        case NodeKind::VARIABLE:
+            handle(node, 7);
+            break;
+        case NodeKind::NO_OPERATOR:
+            handle(node, 8);
+            break;
+        case NodeKind::DOUBLE_CONDITION:
+            handle(node, 9);
+            break;
+        case NodeKind::NEGATION:
+            handle(node, 10);
+            break;
+        case NodeKind::VARIABLE_DECLARATION:
+            handle(node, 11);
+            break;
+        case NodeKind::IF_CONDITION:
+            handle(node, 12);
+            break;
+        case NodeKind::PRINT:
+            handle(node, 13);
+            break;
+        case NodeKind::ARRAY_INIT:
+            handle(node, 14);
+            break;
+        case NodeKind::ARRAY_ACCESS:
+            handle(node, 15);
+            break;
+        case NodeKind::FUNCTION_INIT:
+            handle(node, 16);
+            break;
+        case NodeKind::FUNCTION_CALL:
+            handle(node, 17);
+            break;
+        case NodeKind::RETURN:
+            handle(node, 18);
+            break;
+        case NodeKind::WHILE_LOOP:
+            handle(node, 19);
+            break;
+        case NodeKind::CAST_VALUE:
+            handle(node, 20);
+            break;
+        case NodeKind::IMPORT:
+            handle(node, 21);
+            break;
+        case NodeKind::OBJECT_DIVE:
+            handle(node, 22);
+            break;
+        default:
+            break;
+    }
+}
+
+template<typename Dispatch>
+static double ns_per_node(std::vector<AST*>& nodes, int rounds, Dispatch dispatch) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for(int r = 0; r < rounds; r++) {
+        for(AST* node : nodes) {
+            dispatch(node);
+        }
+    }
+
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / ((double) rounds * nodes.size());
+}
+
+int main() {
+    Token* number = new Token(TokenType::FLOAT, "1");
+    Token* name = new Token(TokenType::IDENTIFIER, "x");
+    Token* plus = new Token(TokenType::PLUS, "+");
+    Token* path = new Token(TokenType::STRING, "lib.mist");
+
+    Variable* var = new Variable(name);
+
+    // Roughly the mix of nodes executed by a loop body such as
+    // `s = s + obj:data[i]; i = i + 1;`, plus a few nodes from the
+    // bottom of the old chain.
+    std::vector<AST*> nodes = {
+        var,
+        new Value(number),
+        new BinaryOperator(var, plus, var),
+        new Assign(var, plus, var),
+        new ArrayAccess(var, var),
+        new ObjectDive(var, name, var),
+        new FunctionCall(var, {}),
+        new Compare({ var, var }, { plus }),
+        new CastValue(var, name),
+        new Import(path, "lib"),
+        new NoOperator()
+    };
+
+    int rounds = 2000000;
+
+    ns_per_node(nodes, rounds / 10, dispatch_dynamic_cast);
+    double before = ns_per_node(nodes, rounds, dispatch_dynamic_cast);
+
+    ns_per_node(nodes, rounds / 10, dispatch_kind);
+    double after = ns_per_node(nodes, rounds, dispatch_kind);
+
+    std::cout << "dynamic_cast chain: " << before << " ns/node" << std::endl;
+    std::cout << "kind switch:        " << after << " ns/node" << std::endl;
+    std::cout << "speedup:            " << before / after << "x" << std::endl;
+
+    return 0;
+}
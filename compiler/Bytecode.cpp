@@ -0,0 +1,27 @@
+#include "Bytecode.h"
+
+Chunk::Chunk(std::string name) {
+    this->name = name;
+}
+
+int Chunk::emit(OpCode op, int32_t arg, Token* token) {
+    code.push_back({ op, 0, arg });
+    tokens.push_back(token);
+
+    return code.size() - 1;
+}
+
+int Chunk::add_constant(TaggedValue value) {
+    constants.push_back(value);
+    return constants.size() - 1;
+}
+
+int Chunk::add_cache(MemberCache* cache) {
+    caches.push_back(cache);
+    return caches.size() - 1;
+}
+
+int Chunk::add_scope(SymbolTable* scope) {
+    scopes.push_back(scope);
+    return scopes.size() - 1;
+}
@@ -0,0 +1,100 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "../lexer/Token.h"
+#include "../interpreter/Memory.h"
+
+enum class OpCode : uint8_t {
+    CONSTANT,
+    NONE,
+    POP,
+
+    LOAD_LOCAL,
+    LOAD_VAR,
+    STORE_LOCAL,
+    STORE_VAR,
+
+    ADD,
+    SUB,
+    MULT,
+    DIV,
+    INT_DIV,
+    MODULO,
+    MINUS,
+    NOT,
+
+    EQUALS,
+    NOT_EQUALS,
+    LESS,
+    LESS_OR_EQ,
+    MORE,
+    MORE_OR_EQ,
+
+    JUMP,
+    JUMP_IF_FALSE,
+    JUMP_IF_TRUE,
+
+    FOR_RANGE,
+    FOR_RANGE_NEXT,
+    FOR_RANGE_STEP,
+    FOR_EACH,
+    FOR_EACH_NEXT,
+
+    ENTER_BLOCK,
+    LEAVE_BLOCK,
+
+    PRINT,
+    BUILD_ARRAY,
+    BUILD_MAP,
+    INDEX,
+    STORE_INDEX,
+    DELETE_INDEX,
+    CAST,
+
+    MAKE_FUNCTION,
+    CALL,
+    TAIL_CALL,
+    RETURN,
+
+    IMPORT,
+    OBJECT_DIVE,
+    STORE_MEMBER,
+    MAKE_INSTANCE,
+    END
+};
+
+// A single fixed-width instruction. The meaning of arg depends on the
+// opcode: a constant, name, scope or slot index, a jump target, an argument
+// count. depth is the number of enclosing blocks LOAD_VAR/STORE_VAR walk up.
+struct Instruction {
+    OpCode op;
+    uint16_t depth;
+    int32_t arg;
+};
+
+// Linear bytecode for one program or function body. tokens runs parallel
+// to code and is only consulted when an instruction reports an error.
+class Chunk {
+    public:
+        std::string name;
+
+        std::vector<Instruction> code;
+        std::vector<Token*> tokens;
+
+        std::vector<TaggedValue> constants;
+        std::vector<MemberCache*> caches;
+        std::vector<SymbolTable*> scopes;
+
+        Chunk(std::string name);
+
+        int emit(OpCode op, int32_t arg, Token* token);
+
+        int add_constant(TaggedValue value);
+        int add_cache(MemberCache* cache);
+        int add_scope(SymbolTable* scope);
+};
+
+#endif
@@ -0,0 +1,596 @@
+#include "Compiler.h"
+
+Compiler::Compiler() {
+    chunk = NULL;
+    last_token = NULL;
+    function_depth = 0;
+}
+
+Chunk* Compiler::compile(AST* tree) {
+    chunk = new Chunk("<module>");
+
+    Compound* program = (Compound*) tree;
+    for(AST* node : program->children) {
+        visit_statement(node);
+    }
+
+    emit(OpCode::END, 0, last_token);
+    return chunk;
+}
+
+void Compiler::visit(AST* node) {
+    if(node->token != NULL) {
+        last_token = node->token;
+    }
+
+    switch(node->kind) {
+        case NodeKind::BINARY_OPERATOR:
+            visit_binary_op((BinaryOperator*) node);
+            break;
+
+        case NodeKind::UNARY_OPERATOR:
+            visit_unary_op((UnaryOperator*) node);
+            break;
+
+        case NodeKind::VALUE:
+            visit_value((Value*) node);
+            break;
+
+        case NodeKind::COMPARE:
+            visit_compare((Compare*) node);
+            break;
+
+        case NodeKind::COMPOUND:
+            visit_compound((Compound*) node);
+            break;
+
+        case NodeKind::ASSIGN:
+            visit_assign((Assign*) node);
+            break;
+
+        case NodeKind::VARIABLE:
+            visit_variable((Variable*) node);
+            break;
+
+        case NodeKind::DOUBLE_CONDITION:
+            visit_double_condition((DoubleCondition*) node);
+            break;
+
+        case NodeKind::NEGATION:
+            visit_negation((Negation*) node);
+            break;
+
+        case NodeKind::VARIABLE_DECLARATION:
+            visit_var_declaration((VariableDeclaration*) node);
+            break;
+
+        case NodeKind::IF_CONDITION:
+            visit_if_condition((IfCondition*) node);
+            break;
+
+        case NodeKind::PRINT:
+            visit_print((Print*) node);
+            break;
+
+        case NodeKind::ARRAY_INIT:
+            visit_array_init((ArrayInit*) node);
+            break;
+
+        case NodeKind::ARRAY_ACCESS:
+            visit_array_access((ArrayAccess*) node);
+            break;
+
+        case NodeKind::MAP_INIT:
+            visit_map_init((MapInit*) node);
+            break;
+
+        case NodeKind::DELETE:
+            visit_delete((Delete*) node);
+            break;
+
+        case NodeKind::FUNCTION_INIT:
+        case NodeKind::CLASS_INIT:
+            visit_function_init((FunctionInit*) node);
+            break;
+
+        case NodeKind::FUNCTION_CALL:
+            visit_function_call((FunctionCall*) node);
+            break;
+
+        case NodeKind::RETURN:
+            visit_return((Return*) node);
+            break;
+
+        case NodeKind::WHILE_LOOP:
+            visit_while_loop((WhileLoop*) node);
+            break;
+
+        case NodeKind::FOR_LOOP:
+            visit_for_loop((ForLoop*) node);
+            break;
+
+        case NodeKind::CAST_VALUE:
+            visit_cast_value((CastValue*) node);
+            break;
+
+        case NodeKind::IMPORT:
+            visit_import((Import*) node);
+            break;
+
+        case NodeKind::OBJECT_DIVE:
+            visit_object_dive((ObjectDive*) node);
+            break;
+
+        case NodeKind::NO_OPERATOR:
+            break;
+
+        default:
+        {
+            std::string message = "Unknown AST branch.";
+            Token* token = token_of(node);
+            Error(token->file, token->line, token->column, message).cast();
+        }
+    }
+}
+
+void Compiler::visit_statement(AST* node) {
+    visit(node);
+
+    if(is_expression(node)) {
+        emit(OpCode::POP, 0, last_token);
+    }
+}
+
+bool Compiler::is_expression(AST* node) {
+    switch(node->kind) {
+        case NodeKind::COMPOUND:
+        case NodeKind::ASSIGN:
+        case NodeKind::VARIABLE_DECLARATION:
+        case NodeKind::NO_OPERATOR:
+        case NodeKind::IF_CONDITION:
+        case NodeKind::PRINT:
+        case NodeKind::FUNCTION_INIT:
+        case NodeKind::CLASS_INIT:
+        case NodeKind::RETURN:
+        case NodeKind::WHILE_LOOP:
+        case NodeKind::FOR_LOOP:
+        case NodeKind::IMPORT:
+        case NodeKind::DELETE:
+            return false;
+
+        default:
+            return true;
+    }
+}
+
+Token* Compiler::token_of(AST* node) {
+    if(node->token != NULL) {
+        return node->token;
+    }
+
+    switch(node->kind) {
+        case NodeKind::COMPARE:
+            return token_of(((Compare*) node)->comparables[0]);
+
+        case NodeKind::FUNCTION_CALL:
+            return token_of(((FunctionCall*) node)->function);
+
+        case NodeKind::ARRAY_ACCESS:
+            return token_of(((ArrayAccess*) node)->array);
+
+        default:
+            return last_token;
+    }
+}
+
+int Compiler::emit(OpCode op, int32_t arg, Token* token) {
+    return chunk->emit(op, arg, token);
+}
+
+void Compiler::emit_variable(OpCode local_op, OpCode var_op, Variable* var) {
+    if(var->depth == 0) {
+        emit(local_op, var->slot, var->token);
+        return;
+    }
+
+    int at = emit(var_op, var->slot, var->token);
+    chunk->code[at].depth = var->depth;
+}
+
+int Compiler::emit_jump(OpCode op, Token* token) {
+    return emit(op, -1, token);
+}
+
+void Compiler::patch_jump(int at) {
+    chunk->code[at].arg = chunk->code.size();
+}
+
+void Compiler::visit_binary_op(BinaryOperator* op) {
+    visit(op->left);
+    visit(op->right);
+
+    OpCode code;
+
+    switch(op->op->type) {
+        case TokenType::PLUS:
+            code = OpCode::ADD;
+            break;
+        case TokenType::MINUS:
+            code = OpCode::SUB;
+            break;
+        case TokenType::MULT:
+            code = OpCode::MULT;
+            break;
+        case TokenType::DIV:
+            code = OpCode::DIV;
+            break;
+        case TokenType::INT_DIV:
+            code = OpCode::INT_DIV;
+            break;
+        default:
+            code = OpCode::MODULO;
+    }
+
+    emit(code, 0, token_of(op->right));
+}
+
+void Compiler::visit_unary_op(UnaryOperator* op) {
+    visit(op->expr);
+
+    if(op->op->type_of(TokenType::MINUS)) {
+        emit(OpCode::MINUS, 0, token_of(op->expr));
+    }
+}
+
+void Compiler::visit_value(Value* val) {
+    switch(val->token->type) {
+        case TokenType::FLOAT:
+            emit(OpCode::CONSTANT, chunk->add_constant(TaggedValue(val->number)), val->token);
+            break;
+
+        case TokenType::INT:
+            emit(OpCode::CONSTANT, chunk->add_constant(TaggedValue(val->integer)), val->token);
+            break;
+
+        case TokenType::BOOLEAN:
+            emit(OpCode::CONSTANT, chunk->add_constant(TaggedValue(val->value == Values::TRUE)), val->token);
+            break;
+
+        case TokenType::STRING:
+            emit(OpCode::CONSTANT, chunk->add_constant(TaggedValue(new String(val->value))), val->token);
+            break;
+
+        default:
+            emit(OpCode::NONE, 0, val->token);
+    }
+}
+
+static OpCode compare_opcode(Token* op) {
+    switch(op->type) {
+        case TokenType::EQUALS:
+            return OpCode::EQUALS;
+        case TokenType::NOT_EQUALS:
+            return OpCode::NOT_EQUALS;
+        case TokenType::LESS:
+            return OpCode::LESS;
+        case TokenType::LESS_OR_EQ:
+            return OpCode::LESS_OR_EQ;
+        case TokenType::MORE:
+            return OpCode::MORE;
+        default:
+            return OpCode::MORE_OR_EQ;
+    }
+}
+
+void Compiler::visit_compare(Compare* c) {
+    std::vector<int> false_jumps;
+    int last = c->operators.size() - 1;
+
+    // Every operand is evaluated once. Each link but the last keeps its
+    // right operand on the stack as the left operand of the next one.
+    visit(c->comparables[0]);
+
+    for(int i = 0; i <= last; i++) {
+        AST* left = c->comparables[i];
+
+        visit(c->comparables[i + 1]);
+        emit(compare_opcode(c->operators[i]), i != last, token_of(left));
+
+        if(i != last) {
+            false_jumps.push_back(emit_jump(OpCode::JUMP_IF_FALSE, token_of(left)));
+        }
+    }
+
+    if(!false_jumps.empty()) {
+        int end_jump = emit_jump(OpCode::JUMP, last_token);
+
+        for(int jump : false_jumps) {
+            patch_jump(jump);
+        }
+        emit(OpCode::POP, 0, last_token);
+        emit(OpCode::CONSTANT, chunk->add_constant(TaggedValue(false)), last_token);
+
+        patch_jump(end_jump);
+    }
+}
+
+void Compiler::visit_compound(Compound* comp) {
+    for(AST* node : comp->children) {
+        visit_statement(node);
+    }
+}
+
+void Compiler::visit_block(Compound* comp) {
+    bool new_block = comp->scope != NULL;
+
+    if(new_block) {
+        emit(OpCode::ENTER_BLOCK, chunk->add_scope(comp->scope), last_token);
+    }
+
+    visit_compound(comp);
+
+    if(new_block) {
+        emit(OpCode::LEAVE_BLOCK, 0, last_token);
+    }
+}
+
+void Compiler::visit_assign(Assign* assign) {
+    AST* left = assign->left;
+
+    if(left->kind == NodeKind::VARIABLE) {
+        Variable* var = (Variable*) left;
+
+        visit(assign->right);
+        emit_variable(OpCode::STORE_LOCAL, OpCode::STORE_VAR, var);
+
+    } else if(left->kind == NodeKind::ARRAY_ACCESS) {
+        ArrayAccess* arr_acc = (ArrayAccess*) left;
+
+        visit(arr_acc->array);
+        visit(arr_acc->index);
+        visit(assign->right);
+        emit(OpCode::STORE_INDEX, 0, token_of(arr_acc->index));
+
+    } else if(left->kind == NodeKind::OBJECT_DIVE) {
+        ObjectDive* dive = (ObjectDive*) left;
+
+        visit(dive->parent);
+        visit(assign->right);
+        emit(OpCode::STORE_MEMBER, chunk->add_cache(dive->cache), dive->child->token);
+    }
+}
+
+void Compiler::visit_variable(Variable* var) {
+    emit_variable(OpCode::LOAD_LOCAL, OpCode::LOAD_VAR, var);
+}
+
+// `and` jumps to a False result as soon as an operand is false, `or` to a
+// True result as soon as one is true; the right operand is only evaluated
+// when the left one does not decide.
+void Compiler::visit_double_condition(DoubleCondition* cond) {
+    bool is_and = cond->op->type_of(TokenType::AND);
+    OpCode jump = is_and ? OpCode::JUMP_IF_FALSE : OpCode::JUMP_IF_TRUE;
+
+    visit(cond->left);
+    int left_jump = emit_jump(jump, cond->op);
+
+    visit(cond->right);
+    int right_jump = emit_jump(jump, cond->op);
+
+    emit(OpCode::CONSTANT, chunk->add_constant(TaggedValue(is_and)), cond->op);
+    int end_jump = emit_jump(OpCode::JUMP, cond->op);
+
+    patch_jump(left_jump);
+    patch_jump(right_jump);
+    emit(OpCode::CONSTANT, chunk->add_constant(TaggedValue(!is_and)), cond->op);
+
+    patch_jump(end_jump);
+}
+
+void Compiler::visit_negation(Negation* neg) {
+    visit(neg->statement);
+    emit(OpCode::NOT, 0, token_of(neg->statement));
+}
+
+void Compiler::visit_var_declaration(VariableDeclaration* decl) {
+    for(size_t i = 0; i < decl->variables.size(); i++) {
+        Variable* var = decl->variables[i];
+
+        if(i < decl->assignments.size()) {
+            visit(decl->assignments[i]->right);
+        } else {
+            emit(OpCode::CONSTANT, chunk->add_constant(TaggedValue()), var->token);
+        }
+
+        emit(OpCode::STORE_LOCAL, var->slot, var->token);
+    }
+}
+
+void Compiler::visit_if_condition(IfCondition* cond) {
+    std::vector<IfCondition*> branches = { cond };
+    branches.insert(branches.end(), cond->elses.begin(), cond->elses.end());
+
+    std::vector<int> end_jumps;
+
+    for(IfCondition* branch : branches) {
+        // A branch the Optimizer proved is always taken ends the chain.
+        if(branch->condition == NULL) {
+            visit_block(branch->statement);
+            break;
+        }
+
+        visit(branch->condition);
+        int next_branch = emit_jump(OpCode::JUMP_IF_FALSE, token_of(branch->condition));
+
+        visit_block(branch->statement);
+        end_jumps.push_back(emit_jump(OpCode::JUMP, last_token));
+
+        patch_jump(next_branch);
+    }
+
+    for(int jump : end_jumps) {
+        patch_jump(jump);
+    }
+}
+
+void Compiler::visit_print(Print* print) {
+    visit(print->printable);
+    emit(OpCode::PRINT, 0, token_of(print->printable));
+}
+
+void Compiler::visit_array_init(ArrayInit* array_init) {
+    for(AST* el : array_init->elements) {
+        visit(el);
+    }
+    emit(OpCode::BUILD_ARRAY, array_init->elements.size(), last_token);
+}
+
+void Compiler::visit_array_access(ArrayAccess* access) {
+    visit(access->array);
+    visit(access->index);
+    emit(OpCode::INDEX, 0, token_of(access->index));
+}
+
+// Pushes each key followed by its value.
+void Compiler::visit_map_init(MapInit* map_init) {
+    for(size_t i = 0; i < map_init->keys.size(); i++) {
+        visit(map_init->keys[i]);
+        visit(map_init->values[i]);
+    }
+    emit(OpCode::BUILD_MAP, map_init->keys.size(), map_init->token);
+}
+
+void Compiler::visit_delete(Delete* del) {
+    visit(del->target->array);
+    visit(del->target->index);
+    emit(OpCode::DELETE_INDEX, 0, token_of(del->target->index));
+}
+
+void Compiler::visit_function_init(FunctionInit* func_init) {
+    Chunk* enclosing_chunk = chunk;
+    chunk = new Chunk(func_init->func_name);
+    function_depth++;
+
+    visit_compound(func_init->block);
+
+    if(func_init->kind == NodeKind::CLASS_INIT) {
+        emit(OpCode::MAKE_INSTANCE, 0, last_token);
+    } else {
+        emit(OpCode::NONE, 0, last_token);
+    }
+    emit(OpCode::RETURN, 0, last_token);
+
+    Chunk* body = chunk;
+    chunk = enclosing_chunk;
+    function_depth--;
+
+    TaggedValue function = TaggedValue(new Function(func_init, body, NULL));
+
+    emit(OpCode::MAKE_FUNCTION, chunk->add_constant(function), last_token);
+    emit(OpCode::STORE_LOCAL, func_init->slot, last_token);
+}
+
+void Compiler::visit_function_call(FunctionCall* func_call) {
+    Token* token = token_of(func_call->function);
+
+    visit(func_call->function);
+    for(AST* param : func_call->params) {
+        visit(param);
+    }
+
+    emit(OpCode::CALL, func_call->params.size(), token);
+}
+
+void Compiler::visit_return(Return* ret) {
+    if(function_depth == 0) {
+        std::string message = "Return statement without function declaration.";
+        Token* token = ret->token;
+        SyntaxError(token->file, token->line, token->column, message).cast();
+    }
+
+    // A returned call reuses the current CallFrame, so tail recursion runs
+    // in constant space. A native callee leaves its result on the stack and
+    // falls through to the RETURN.
+    if(ret->returnable->kind == NodeKind::FUNCTION_CALL) {
+        FunctionCall* func_call = (FunctionCall*) ret->returnable;
+
+        visit(func_call->function);
+        for(AST* param : func_call->params) {
+            visit(param);
+        }
+
+        emit(OpCode::TAIL_CALL, func_call->params.size(), token_of(func_call->function));
+        emit(OpCode::RETURN, 0, ret->token);
+        return;
+    }
+
+    visit(ret->returnable);
+    emit(OpCode::RETURN, 0, ret->token);
+}
+
+// The bounds are pushed in the enclosing block and stored into the slots
+// of the loop's block, where FOR_RANGE_NEXT/FOR_RANGE_STEP (or
+// FOR_EACH_NEXT) test and advance them in place.
+void Compiler::visit_for_loop(ForLoop* for_loop) {
+    Token* token = for_loop->token;
+    bool range = for_loop->end != NULL;
+
+    visit(for_loop->start);
+
+    if(range) {
+        visit(for_loop->end);
+
+        if(for_loop->step != NULL) {
+            visit(for_loop->step);
+        } else {
+            emit(OpCode::CONSTANT, chunk->add_constant(TaggedValue((int64_t) 1)), token);
+        }
+    }
+
+    emit(OpCode::ENTER_BLOCK, chunk->add_scope(for_loop->scope), token);
+
+    if(range) {
+        emit(OpCode::STORE_LOCAL, 2, token);
+        emit(OpCode::STORE_LOCAL, 1, token);
+        emit(OpCode::STORE_LOCAL, 0, token);
+        emit(OpCode::FOR_RANGE, 0, token);
+    } else {
+        emit(OpCode::STORE_LOCAL, 1, token);
+        emit(OpCode::FOR_EACH, 0, token_of(for_loop->start));
+    }
+
+    int loop_start = chunk->code.size();
+    int exit_jump = emit_jump(range ? OpCode::FOR_RANGE_NEXT : OpCode::FOR_EACH_NEXT, token);
+
+    visit_block(for_loop->statement);
+    emit(range ? OpCode::FOR_RANGE_STEP : OpCode::JUMP, loop_start, token);
+
+    patch_jump(exit_jump);
+    emit(OpCode::LEAVE_BLOCK, 0, token);
+}
+
+void Compiler::visit_while_loop(WhileLoop* while_loop) {
+    int loop_start = chunk->code.size();
+
+    visit(while_loop->condition);
+    int exit_jump = emit_jump(OpCode::JUMP_IF_FALSE, token_of(while_loop->condition));
+
+    visit_block(while_loop->statement);
+    emit(OpCode::JUMP, loop_start, last_token);
+
+    patch_jump(exit_jump);
+}
+
+void Compiler::visit_cast_value(CastValue* cast) {
+    visit(cast->value);
+    emit(OpCode::CAST, 0, cast->type);
+}
+
+void Compiler::visit_import(Import* import) {
+    emit(OpCode::IMPORT, import->slot, import->token);
+}
+
+void Compiler::visit_object_dive(ObjectDive* dive) {
+    visit(dive->parent);
+    emit(OpCode::OBJECT_DIVE, chunk->add_cache(dive->cache), dive->child->token);
+}
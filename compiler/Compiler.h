@@ -0,0 +1,63 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include "Bytecode.h"
+#include "../parser/AST.h"
+#include "../utils/Values.h"
+#include "../utils/Error.h"
+
+// Translates a parsed and analyzed AST into linear bytecode for the VM.
+// Every FunctionInit gets its own Chunk, referenced from the constant pool
+// of the chunk it was declared in.
+class Compiler {
+    public:
+        Compiler();
+
+        Chunk* compile(AST* tree);
+
+    private:
+        Chunk* chunk;
+        Token* last_token;
+        int function_depth;
+
+        void visit(AST* node);
+        void visit_statement(AST* node);
+
+        void visit_binary_op(BinaryOperator* op);
+        void visit_unary_op(UnaryOperator* op);
+        void visit_value(Value* val);
+        void visit_compare(Compare* c);
+        void visit_compound(Compound* comp);
+        void visit_assign(Assign* assign);
+        void visit_variable(Variable* var);
+        void visit_double_condition(DoubleCondition* cond);
+        void visit_negation(Negation* neg);
+        void visit_var_declaration(VariableDeclaration* decl);
+        void visit_if_condition(IfCondition* cond);
+        void visit_print(Print* print);
+        void visit_array_init(ArrayInit* array_init);
+        void visit_array_access(ArrayAccess* access);
+        void visit_map_init(MapInit* map_init);
+        void visit_delete(Delete* del);
+        void visit_function_init(FunctionInit* func_init);
+        void visit_function_call(FunctionCall* func_call);
+        void visit_return(Return* ret);
+        void visit_while_loop(WhileLoop* while_loop);
+        void visit_for_loop(ForLoop* for_loop);
+        void visit_cast_value(CastValue* cast);
+        void visit_import(Import* import);
+        void visit_object_dive(ObjectDive* dive);
+
+        void visit_block(Compound* comp);
+
+        bool is_expression(AST* node);
+
+        Token* token_of(AST* node);
+
+        int emit(OpCode op, int32_t arg, Token* token);
+        void emit_variable(OpCode local_op, OpCode var_op, Variable* var);
+        int emit_jump(OpCode op, Token* token);
+        void patch_jump(int at);
+};
+
+#endif
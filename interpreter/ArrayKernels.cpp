@@ -0,0 +1,347 @@
+#include "ArrayKernels.h"
+#include <cstring>
+#include <cmath>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define SIMD_KERNEL __attribute__((target_clones("avx2", "default")))
+#else
+#define SIMD_KERNEL
+#endif
+
+#define INLINE __attribute__((always_inline)) inline
+
+typedef double double4 __attribute__((vector_size(32)));
+typedef int64_t int4 __attribute__((vector_size(32)));
+typedef uint64_t uint4 __attribute__((vector_size(32)));
+
+static const size_t lanes = 4;
+
+// Vectors are passed out through references: a 32-byte vector returned by
+// value changes the ABI between the avx2 and default clones.
+template<typename Vector, typename Element>
+static INLINE void load(Vector& vector, const Element* values) {
+    memcpy(&vector, values, sizeof(vector));
+}
+
+template<typename Vector, typename Element>
+static INLINE void store(Element* values, const Vector& vector) {
+    memcpy(values, &vector, sizeof(vector));
+}
+
+template<typename Vector, typename Element>
+static INLINE void splat(Vector& vector, Element value) {
+    vector = Vector{ value, value, value, value };
+}
+
+template<TokenType op, typename T>
+static INLINE void combine(T& result, const T& x, const T& y) {
+    if constexpr(op == TokenType::PLUS) {
+        result = x + y;
+    } else if constexpr(op == TokenType::MINUS) {
+        result = x - y;
+    } else if constexpr(op == TokenType::MULT) {
+        result = x * y;
+    } else {
+        result = x / y;
+    }
+}
+
+template<TokenType op>
+static INLINE void apply_doubles(const double* a, bool a_scalar, const double* b, bool b_scalar, double* out, size_t n) {
+    size_t i = 0;
+
+    for(; i + lanes <= n; i += lanes) {
+        double4 x, y, r;
+
+        if(a_scalar) {
+            splat(x, *a);
+        } else {
+            load(x, a + i);
+        }
+
+        if(b_scalar) {
+            splat(y, *b);
+        } else {
+            load(y, b + i);
+        }
+        combine<op>(r, x, y);
+        store(out + i, r);
+    }
+
+    for(; i < n; i++) {
+        combine<op>(out[i], a[a_scalar ? 0 : i], b[b_scalar ? 0 : i]);
+    }
+}
+
+SIMD_KERNEL
+void ArrayKernels::apply(TokenType op, const double* a, bool a_scalar, const double* b, bool b_scalar, double* out, size_t n) {
+    switch(op) {
+        case TokenType::PLUS:
+            apply_doubles<TokenType::PLUS>(a, a_scalar, b, b_scalar, out, n);
+            break;
+
+        case TokenType::MINUS:
+            apply_doubles<TokenType::MINUS>(a, a_scalar, b, b_scalar, out, n);
+            break;
+
+        case TokenType::MULT:
+            apply_doubles<TokenType::MULT>(a, a_scalar, b, b_scalar, out, n);
+            break;
+
+        default:
+            apply_doubles<TokenType::DIV>(a, a_scalar, b, b_scalar, out, n);
+    }
+}
+
+// Integers are added in unsigned lanes, which wrap; a signed overflow shows
+// up as a result whose sign disagrees with what the operands allow.
+template<TokenType op>
+static INLINE bool apply_integers(const int64_t* a, bool a_scalar, const int64_t* b, bool b_scalar, int64_t* out, size_t n) {
+    uint4 overflow = uint4{ 0, 0, 0, 0 };
+    size_t i = 0;
+
+    for(; i + lanes <= n; i += lanes) {
+        uint4 x, y, r;
+
+        if(a_scalar) {
+            splat(x, (uint64_t) *a);
+        } else {
+            load(x, a + i);
+        }
+
+        if(b_scalar) {
+            splat(y, (uint64_t) *b);
+        } else {
+            load(y, b + i);
+        }
+        combine<op>(r, x, y);
+
+        if constexpr(op == TokenType::PLUS) {
+            overflow |= (x ^ r) & (y ^ r);
+        } else {
+            overflow |= (x ^ y) & (x ^ r);
+        }
+        store(out + i, r);
+    }
+
+    bool failed = false;
+
+    for(size_t lane = 0; lane < lanes; lane++) {
+        failed = failed || (overflow[lane] >> 63);
+    }
+
+    for(; i < n && !failed; i++) {
+        int64_t x = a[a_scalar ? 0 : i];
+        int64_t y = b[b_scalar ? 0 : i];
+
+        if constexpr(op == TokenType::PLUS) {
+            failed = __builtin_add_overflow(x, y, &out[i]);
+        } else {
+            failed = __builtin_sub_overflow(x, y, &out[i]);
+        }
+    }
+
+    return !failed;
+}
+
+SIMD_KERNEL
+bool ArrayKernels::apply(TokenType op, const int64_t* a, bool a_scalar, const int64_t* b, bool b_scalar, int64_t* out, size_t n) {
+    if(op == TokenType::PLUS) {
+        return apply_integers<TokenType::PLUS>(a, a_scalar, b, b_scalar, out, n);
+    }
+    return apply_integers<TokenType::MINUS>(a, a_scalar, b, b_scalar, out, n);
+}
+
+// Reductions keep one accumulator per lane, so their floating point sums
+// associate differently from a plain left-to-right loop.
+SIMD_KERNEL
+double ArrayKernels::sum(const double* values, size_t n) {
+    double4 total = double4{ 0.0, 0.0, 0.0, 0.0 };
+    size_t i = 0;
+
+    for(; i + lanes <= n; i += lanes) {
+        double4 x;
+        load(x, values + i);
+        total += x;
+    }
+
+    double result = (total[0] + total[1]) + (total[2] + total[3]);
+
+    for(; i < n; i++) {
+        result += values[i];
+    }
+    return result;
+}
+
+SIMD_KERNEL
+double ArrayKernels::dot(const double* a, const double* b, size_t n) {
+    double4 total = double4{ 0.0, 0.0, 0.0, 0.0 };
+    size_t i = 0;
+
+    for(; i + lanes <= n; i += lanes) {
+        double4 x, y;
+        load(x, a + i);
+        load(y, b + i);
+        total += x * y;
+    }
+
+    double result = (total[0] + total[1]) + (total[2] + total[3]);
+
+    for(; i < n; i++) {
+        result += a[i] * b[i];
+    }
+    return result;
+}
+
+template<bool maximum, typename Vector, typename Element>
+static INLINE Element extreme(const Element* values, size_t n) {
+    Element result = values[0];
+    size_t i = 0;
+
+    if(n >= lanes) {
+        Vector best, next;
+        load(best, values);
+
+        for(i = lanes; i + lanes <= n; i += lanes) {
+            load(next, values + i);
+            best = maximum ? (next > best ? next : best) : (next < best ? next : best);
+        }
+
+        for(size_t lane = 0; lane < lanes; lane++) {
+            result = maximum ? (best[lane] > result ? best[lane] : result) : (best[lane] < result ? best[lane] : result);
+        }
+    }
+
+    for(; i < n; i++) {
+        result = maximum ? (values[i] > result ? values[i] : result) : (values[i] < result ? values[i] : result);
+    }
+    return result;
+}
+
+SIMD_KERNEL
+double ArrayKernels::min(const double* values, size_t n) {
+    return extreme<false, double4>(values, n);
+}
+
+SIMD_KERNEL
+double ArrayKernels::max(const double* values, size_t n) {
+    return extreme<true, double4>(values, n);
+}
+
+// A lane that overflows does not mean the total does, so that case is
+// summed again one element at a time.
+SIMD_KERNEL
+bool ArrayKernels::sum(const int64_t* values, size_t n, int64_t& result) {
+    uint4 total = uint4{ 0, 0, 0, 0 };
+    uint4 overflow = uint4{ 0, 0, 0, 0 };
+    size_t i = 0;
+
+    for(; i + lanes <= n; i += lanes) {
+        uint4 x;
+        load(x, values + i);
+        uint4 r = total + x;
+
+        overflow |= (total ^ r) & (x ^ r);
+        total = r;
+    }
+
+    bool failed = false;
+    result = 0;
+
+    for(size_t lane = 0; lane < lanes; lane++) {
+        failed = failed || (overflow[lane] >> 63) || __builtin_add_overflow(result, (int64_t) total[lane], &result);
+    }
+
+    if(failed) {
+        result = 0;
+        i = 0;
+    }
+
+    for(; i < n; i++) {
+        if(__builtin_add_overflow(result, values[i], &result)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+SIMD_KERNEL
+int64_t ArrayKernels::min(const int64_t* values, size_t n) {
+    return extreme<false, int4>(values, n);
+}
+
+SIMD_KERNEL
+int64_t ArrayKernels::max(const int64_t* values, size_t n) {
+    return extreme<true, int4>(values, n);
+}
+
+// Vector types have no square root or rounding, so these two use the
+// instructions directly: AVX for whole vectors where the CPU has AVX2,
+// SSE2 (square root only) otherwise.
+#if defined(__x86_64__) && defined(__GNUC__)
+
+__attribute__((target("avx2")))
+void ArrayKernels::sqrt(const double* values, double* out, size_t n) {
+    size_t i = 0;
+
+    for(; i + lanes <= n; i += lanes) {
+        _mm256_storeu_pd(out + i, _mm256_sqrt_pd(_mm256_loadu_pd(values + i)));
+    }
+
+    for(; i < n; i++) {
+        out[i] = std::sqrt(values[i]);
+    }
+}
+
+__attribute__((target("default")))
+void ArrayKernels::sqrt(const double* values, double* out, size_t n) {
+    size_t i = 0;
+
+    for(; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(out + i, _mm_sqrt_pd(_mm_loadu_pd(values + i)));
+    }
+
+    for(; i < n; i++) {
+        out[i] = std::sqrt(values[i]);
+    }
+}
+
+__attribute__((target("avx2")))
+void ArrayKernels::floor(const double* values, double* out, size_t n) {
+    size_t i = 0;
+
+    for(; i + lanes <= n; i += lanes) {
+        _mm256_storeu_pd(out + i, _mm256_floor_pd(_mm256_loadu_pd(values + i)));
+    }
+
+    for(; i < n; i++) {
+        out[i] = std::floor(values[i]);
+    }
+}
+
+__attribute__((target("default")))
+void ArrayKernels::floor(const double* values, double* out, size_t n) {
+    for(size_t i = 0; i < n; i++) {
+        out[i] = std::floor(values[i]);
+    }
+}
+
+#else
+
+void ArrayKernels::sqrt(const double* values, double* out, size_t n) {
+    for(size_t i = 0; i < n; i++) {
+        out[i] = std::sqrt(values[i]);
+    }
+}
+
+void ArrayKernels::floor(const double* values, double* out, size_t n) {
+    for(size_t i = 0; i < n; i++) {
+        out[i] = std::floor(values[i]);
+    }
+}
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef ARRAY_KERNELS_H
+#define ARRAY_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "../lexer/Token.h"
+
+// Loops over packed array storage, written with vector types so each runs
+// four lanes at a time. On x86-64 every kernel is built twice, for AVX2 and
+// for baseline SSE2, and the loader picks the one the CPU supports.
+namespace ArrayKernels {
+    // out[i] = a[i] op b[i] for op one of + - * /. An operand marked scalar
+    // points at a single value that is used for every i.
+    void apply(TokenType op, const double* a, bool a_scalar, const double* b, bool b_scalar, double* out, size_t n);
+
+    // Same for + and - on int64s. Returns false if any element overflowed,
+    // in which case out is unspecified.
+    bool apply(TokenType op, const int64_t* a, bool a_scalar, const int64_t* b, bool b_scalar, int64_t* out, size_t n);
+
+    // out[i] = sqrt(values[i]) and floor(values[i]).
+    void sqrt(const double* values, double* out, size_t n);
+    void floor(const double* values, double* out, size_t n);
+
+    // min and max need n > 0.
+    double sum(const double* values, size_t n);
+    double dot(const double* a, const double* b, size_t n);
+    double min(const double* values, size_t n);
+    double max(const double* values, size_t n);
+
+    // Returns false if the sum overflows an int64.
+    bool sum(const int64_t* values, size_t n, int64_t& result);
+    int64_t min(const int64_t* values, size_t n);
+    int64_t max(const int64_t* values, size_t n);
+}
+
+#endif
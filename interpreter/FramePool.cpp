@@ -0,0 +1,14 @@
+#include "FramePool.h"
+
+FramePool frame_pool;
+
+FramePool::FramePool() {
+    entered = 0;
+    allocated = 0;
+    top = 0;
+}
+
+void FramePool::print_stats(std::ostream& out) {
+    out << "Scopes: " << entered << " entered, " << allocated << " allocated, "
+        << frames.size() << " pooled" << std::endl;
+}
@@ -0,0 +1,59 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <cstddef>
+#include <vector>
+#include "Memory.h"
+#include "Heap.h"
+
+// Stack allocator for the Memory of blocks and function calls.
+//
+// A scope that no closure can capture (see SymbolTable::captured) is only
+// reachable while it is active, so its Memory is taken from a LIFO stack of
+// unmanaged blocks and handed back when the block exits. Captured scopes
+// are allocated on the collected heap as before. After warm-up a loop body
+// or a non-capturing call therefore allocates nothing.
+class FramePool {
+    public:
+        size_t entered;
+        size_t allocated;
+
+        FramePool();
+
+        Memory* enter(SymbolTable* layout, Memory* enclosing) {
+            entered++;
+
+            if(layout->captured) {
+                allocated++;
+                return heap.track(new Memory(layout, enclosing));
+            }
+
+            if(top == frames.size()) {
+                allocated++;
+                frames.push_back(new Memory(layout, enclosing));
+                return frames[top++];
+            }
+
+            Memory* memory = frames[top++];
+            memory->reset(layout, enclosing);
+            return memory;
+        }
+
+        void leave(Memory* memory) {
+            if(memory->managed) {
+                heap.write_barrier(memory);
+            } else {
+                top--;
+            }
+        }
+
+        void print_stats(std::ostream& out);
+
+    private:
+        std::vector<Memory*> frames;
+        size_t top;
+};
+
+extern FramePool frame_pool;
+
+#endif
@@ -0,0 +1,173 @@
+#include "Heap.h"
+#include "Memory.h"
+#include <algorithm>
+#include <chrono>
+
+Heap heap;
+
+Heap::Heap() {
+    young_limit = 4 * 1024 * 1024;
+    old_limit = 32 * 1024 * 1024;
+    growth_factor = 2.0;
+
+    young_objects = NULL;
+    old_objects = NULL;
+
+    young_bytes = 0;
+    old_bytes = 0;
+    allocated_bytes = 0;
+
+    minor = false;
+
+    minor_collections = 0;
+    major_collections = 0;
+    total_pause_ms = 0;
+    max_pause_ms = 0;
+    reclaimed_bytes = 0;
+    reclaimed_objects = 0;
+}
+
+void Heap::add_roots(RootSet* roots) {
+    root_sets.push_back(roots);
+}
+
+void Heap::remove_roots(RootSet* roots) {
+    root_sets.erase(std::remove(root_sets.begin(), root_sets.end(), roots), root_sets.end());
+}
+
+void Heap::mark(HeapObject* object) {
+    if(object == NULL || !object->managed || object->marked) {
+        return;
+    }
+
+    if(minor && object->old) {
+        return;
+    }
+
+    object->marked = true;
+    gray.push_back(object);
+}
+
+void Heap::mark(TaggedValue& value) {
+    if(value.is_heap()) {
+        mark(value.ref);
+    }
+}
+
+void Heap::mark_chain(Memory* memory) {
+    for(; memory != NULL; memory = memory->enclosing_memory_block) {
+        // Active blocks are written without a barrier, so an old one still
+        // has to be scanned for young values during a minor collection.
+        // Pooled blocks are unmanaged and only reachable from here.
+        if(!memory->managed || (minor && memory->old)) {
+            memory->trace(this);
+        } else {
+            mark(memory);
+        }
+    }
+}
+
+void Heap::mark_roots() {
+    for(RootSet* roots : root_sets) {
+        roots->trace_roots(this);
+    }
+}
+
+void Heap::drain() {
+    while(!gray.empty()) {
+        HeapObject* object = gray.back();
+        gray.pop_back();
+
+        object->trace(this);
+    }
+}
+
+HeapObject* Heap::sweep(HeapObject* list, HeapObject* survivors) {
+    while(list != NULL) {
+        HeapObject* next = list->next_object;
+        size_t bytes = list->size();
+
+        if(list->marked) {
+            list->marked = false;
+            list->old = true;
+            list->next_object = survivors;
+            survivors = list;
+            old_bytes += bytes;
+        } else {
+            reclaimed_bytes += bytes;
+            reclaimed_objects++;
+            delete list;
+        }
+
+        list = next;
+    }
+    return survivors;
+}
+
+void Heap::record_pause(double ms) {
+    total_pause_ms += ms;
+    max_pause_ms = std::max(max_pause_ms, ms);
+}
+
+void Heap::collect() {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    minor = true;
+    mark_roots();
+
+    for(HeapObject* object : remembered_set) {
+        object->remembered = false;
+        object->trace(this);
+    }
+    remembered_set.clear();
+
+    drain();
+    minor = false;
+
+    // Every survivor is promoted, so the old generation holds no young
+    // references afterwards and the remembered set can start empty.
+    old_objects = sweep(young_objects, old_objects);
+    young_objects = NULL;
+    young_bytes = 0;
+
+    minor_collections++;
+    record_pause(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+    if(old_bytes > old_limit) {
+        collect_major();
+    }
+}
+
+void Heap::collect_major() {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    mark_roots();
+    drain();
+
+    for(HeapObject* object : remembered_set) {
+        object->remembered = false;
+    }
+    remembered_set.clear();
+
+    old_bytes = 0;
+    old_objects = sweep(old_objects, sweep(young_objects, NULL));
+    young_objects = NULL;
+    young_bytes = 0;
+
+    old_limit = std::max(old_limit, (size_t) (old_bytes * growth_factor));
+
+    major_collections++;
+    record_pause(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+void Heap::print_stats(std::ostream& out) {
+    int collections = minor_collections + major_collections;
+
+    out << "GC: " << minor_collections << " minor, " << major_collections << " major collections" << std::endl;
+    out << "GC: allocated " << allocated_bytes << " bytes, reclaimed " << reclaimed_bytes
+        << " bytes in " << reclaimed_objects << " objects" << std::endl;
+    out << "GC: heap " << old_bytes + young_bytes << " bytes (old " << old_bytes
+        << ", young " << young_bytes << ")" << std::endl;
+    out << "GC: pause total " << total_pause_ms << " ms, max " << max_pause_ms << " ms, mean "
+        << (collections > 0 ? total_pause_ms / collections : 0) << " ms" << std::endl;
+}
@@ -0,0 +1,133 @@
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <ostream>
+
+class Heap;
+class Memory;
+class TaggedValue;
+
+// Base of everything the collector owns: heap MemoryValues and Memory blocks.
+// Objects created with plain `new` and never passed to Heap::track (such as
+// the constants of a compiled Chunk) are unmanaged and live forever.
+class HeapObject {
+    public:
+        HeapObject* next_object;
+
+        bool managed;
+        bool marked;
+        bool old;
+        bool remembered;
+
+        HeapObject() {
+            this->next_object = NULL;
+            this->managed = false;
+            this->marked = false;
+            this->old = false;
+            this->remembered = false;
+        }
+
+        virtual ~HeapObject() {}
+
+        virtual void trace(Heap* heap) = 0;
+        virtual size_t size() = 0;
+};
+
+// Anything holding references the collector cannot see by itself: the
+// interpreter's memory chain and temporaries, the VM's stack and frames.
+class RootSet {
+    public:
+        virtual void trace_roots(Heap* heap) = 0;
+};
+
+// Generational mark-and-sweep heap.
+//
+// New objects go to the young generation. Once young_limit bytes have been
+// allocated, the next safepoint runs a minor collection, which marks from the
+// roots and the remembered set without entering old objects, frees the dead
+// young objects and promotes the survivors. A major collection marks and
+// sweeps both generations once the old generation outgrows old_limit.
+//
+// Collections only happen at safepoints, where every live value is reachable
+// from a registered RootSet. Memory blocks on the active chain are always
+// scanned, so the only old-to-young references that need a write barrier are
+// stores into array elements, stores into enclosing (non-local) scopes, and
+// blocks that are left while still reachable from a closure or an object.
+class Heap {
+    public:
+        size_t young_limit;
+        size_t old_limit;
+        double growth_factor;
+
+        Heap();
+
+        template<typename T>
+        T* track(T* object) {
+            object->managed = true;
+            object->next_object = young_objects;
+            young_objects = object;
+
+            size_t bytes = object->size();
+            young_bytes += bytes;
+            allocated_bytes += bytes;
+            return object;
+        }
+
+        void safepoint() {
+            if(young_bytes >= young_limit) {
+                collect();
+            }
+        }
+
+        void write_barrier(HeapObject* object) {
+            if(object->old && !object->remembered) {
+                object->remembered = true;
+                remembered_set.push_back(object);
+            }
+        }
+
+        void collect();
+        void collect_major();
+
+        void mark(HeapObject* object);
+        void mark(TaggedValue& value);
+        void mark_chain(Memory* memory);
+
+        void add_roots(RootSet* roots);
+        void remove_roots(RootSet* roots);
+
+        void print_stats(std::ostream& out);
+
+    private:
+        HeapObject* young_objects;
+        HeapObject* old_objects;
+
+        size_t young_bytes;
+        size_t old_bytes;
+        size_t allocated_bytes;
+
+        bool minor;
+
+        std::vector<HeapObject*> gray;
+        std::vector<HeapObject*> remembered_set;
+        std::vector<RootSet*> root_sets;
+
+        int minor_collections;
+        int major_collections;
+        double total_pause_ms;
+        double max_pause_ms;
+        size_t reclaimed_bytes;
+        size_t reclaimed_objects;
+
+        void mark_roots();
+        void drain();
+        HeapObject* sweep(HeapObject* list, HeapObject* survivors);
+        void record_pause(double ms);
+};
+
+extern Heap heap;
+
+#endif
@@ -1,321 +1,203 @@
 #include <iostream>
+#include <chrono>
+#include <sys/resource.h>
 #include "Interpreter.h"
+#include "../utils/Output.h"
 
-void Interpreter::type_mismatch_error(Token* token) {
-    std::string message = "Type mismatch.";
-    std::string file_path = token->file;
-    SyntaxError(file_path, token->line, token->column, message).cast();
+Interpreter::Interpreter() {
+    memory_block = NULL;
+    returning = false;
+    tail_call = NULL;
+    module_name = NULL;
+    statement = NULL;
+
+    heap.add_roots(this);
 }
 
-void Interpreter::value_error(Token* token) {
-    std::string message = "Value cannot be converted to " + token->value + ".";
-    std::string file_path = token->file;
-    ValueError(file_path, token->line, token->column, message).cast();
+Interpreter::~Interpreter() {
+    heap.remove_roots(this);
 }
 
-Interpreter::Interpreter() {
-    memory_block = new Memory(0, NULL);
-    semantic_analyzer = new SemanticAnalyzer();
+void Interpreter::trace_roots(Heap* heap) {
+    for(TaggedValue& value : temporaries) {
+        heap->mark(value);
+    }
+
+    for(Memory* caller : callers) {
+        heap->mark_chain(caller);
+    }
+    heap->mark_chain(memory_block);
 }
 
-void Interpreter::enter_new_memory_block() {
-    memory_block = new Memory(memory_block->memory_level + 1, memory_block);
+void Interpreter::enter_new_memory_block(SymbolTable* scope) {
+    memory_block = frame_pool.enter(scope, memory_block);
 }
 
 void Interpreter::leave_memory_block() {
-    if(memory_block->enclosing_memory_block->memory_level != 0) {
-        memory_block = memory_block->enclosing_memory_block;
-    }
+    Memory* block = memory_block;
+
+    memory_block = block->enclosing_memory_block;
+    frame_pool.leave(block);
 }
 
-MemoryValue* Interpreter::visit(AST* node) {
-    if(BinaryOperator* ast = dynamic_cast<BinaryOperator*>(node)) {
-        return visit_binary_op(ast);
+TaggedValue Interpreter::visit(AST* node) {
+    switch(node->kind) {
+        case NodeKind::BINARY_OPERATOR:
+            return visit_binary_op((BinaryOperator*) node);
 
-    } else if(UnaryOperator* ast = dynamic_cast<UnaryOperator*>(node)) {
-        return visit_unary_op(ast);
+        case NodeKind::UNARY_OPERATOR:
+            return visit_unary_op((UnaryOperator*) node);
 
-    } else if(Value* ast = dynamic_cast<Value*>(node)) {
-        return visit_value(ast);
+        case NodeKind::VALUE:
+            return visit_value((Value*) node);
 
-    } else if(Compare* ast = dynamic_cast<Compare*>(node)) {
-        return visit_compare(ast);
+        case NodeKind::COMPARE:
+            return visit_compare((Compare*) node);
 
-    } else if(Compound* ast = dynamic_cast<Compound*>(node)) {
-        return visit_compound(ast);
+        case NodeKind::COMPOUND:
+            return visit_compound((Compound*) node);
 
-    } else if(Assign* ast = dynamic_cast<Assign*>(node)) {
-        return visit_assign(ast);
+        case NodeKind::ASSIGN:
+            return visit_assign((Assign*) node);
 
-    } else if(Variable* ast = dynamic_cast<Variable*>(node)) {
-        return visit_variable(ast);
+        case NodeKind::VARIABLE:
+            return visit_variable((Variable*) node);
 
-    } else if(NoOperator* ast = dynamic_cast<NoOperator*>(node)) {
-        return visit_no_operator(ast);
-        
-    } else if(DoubleCondition* ast = dynamic_cast<DoubleCondition*>(node)) {
-        return visit_double_condition(ast);
-        
-    } else if(Negation* ast = dynamic_cast<Negation*>(node)) {
-        return visit_negation(ast);
-        
-    } else if(VariableDeclaration* ast = dynamic_cast<VariableDeclaration*>(node)) {
-        return visit_var_declaration(ast);
+        case NodeKind::NO_OPERATOR:
+            return visit_no_operator((NoOperator*) node);
 
-    } else if(IfCondition* ast = dynamic_cast<IfCondition*>(node)) {
-        return visit_if_condition(ast);
+        case NodeKind::DOUBLE_CONDITION:
+            return visit_double_condition((DoubleCondition*) node);
 
-    } else if(Print* ast = dynamic_cast<Print*>(node)) {
-        return visit_print(ast);
+        case NodeKind::NEGATION:
+            return visit_negation((Negation*) node);
 
-    } else if(ArrayInit* ast = dynamic_cast<ArrayInit*>(node)) {
-        return visit_array_init(ast);
+        case NodeKind::VARIABLE_DECLARATION:
+            return visit_var_declaration((VariableDeclaration*) node);
 
-    } else if(ArrayAccess* ast = dynamic_cast<ArrayAccess*>(node)) {
-        return visit_array_access(ast);
+        case NodeKind::IF_CONDITION:
+            return visit_if_condition((IfCondition*) node);
 
-    } else if(FunctionInit* ast = dynamic_cast<FunctionInit*>(node)) {
-        return visit_function_init(ast);
+        case NodeKind::PRINT:
+            return visit_print((Print*) node);
 
-    } else if(FunctionCall* ast = dynamic_cast<FunctionCall*>(node)) {
-        return visit_function_call(ast);
+        case NodeKind::ARRAY_INIT:
+            return visit_array_init((ArrayInit*) node);
 
-    } else if(Return* ast = dynamic_cast<Return*>(node)) {
-        return visit_return(ast);
+        case NodeKind::ARRAY_ACCESS:
+            return visit_array_access((ArrayAccess*) node);
 
-    } else if(WhileLoop* ast = dynamic_cast<WhileLoop*>(node)) {
-        return visit_while_loop(ast);
-        
-    } else if(CastValue* ast = dynamic_cast<CastValue*>(node)) {
-        return visit_cast_value(ast);
-        
-    } else if(Import* ast = dynamic_cast<Import*>(node)) {
-        return visit_import(ast);
+        case NodeKind::MAP_INIT:
+            return visit_map_init((MapInit*) node);
 
-    } else if(ObjectDive* ast = dynamic_cast<ObjectDive*>(node)) {
-        return visit_object_dive(ast);
+        case NodeKind::DELETE:
+            return visit_delete((Delete*) node);
 
-    } 
+        case NodeKind::FUNCTION_INIT:
+        case NodeKind::CLASS_INIT:
+            return visit_function_init((FunctionInit*) node);
 
-    std::string message = "Unknown AST branch.";
-    int line = node->token->line;
-    int column = node->token->column;
-    std::string file_path = node->token->file;
-    Error(file_path, line, column, message).cast();
-} 
-
-MemoryValue* Interpreter::visit_binary_op(BinaryOperator* op) {
-    SingularMemoryValue* left = (SingularMemoryValue*) visit(op->left);
-    SingularMemoryValue* right = (SingularMemoryValue*) visit(op->right);
-
-    switch(op->op->type) {
-        case TokenType::PLUS:
-        {
-            if(left->type == Type::STRING) {
-                if(right->type != Type::STRING) {
-                    type_mismatch_error(op->right->token);
-                }
+        case NodeKind::FUNCTION_CALL:
+            return visit_function_call((FunctionCall*) node);
 
-                std::string a = left->value;
-                std::string b = right->value;
+        case NodeKind::RETURN:
+            return visit_return((Return*) node);
 
-                return new SingularMemoryValue(a + b, Type::STRING);
+        case NodeKind::WHILE_LOOP:
+            return visit_while_loop((WhileLoop*) node);
 
+        case NodeKind::FOR_LOOP:
+            return visit_for_loop((ForLoop*) node);
 
-            } else if(left->type == Type::FLOAT) {
-                if(right->type != Type::FLOAT) {
-                    type_mismatch_error(op->right->token);
-                }
+        case NodeKind::CAST_VALUE:
+            return visit_cast_value((CastValue*) node);
 
-                double x = std::stod(left->value);
-                double y = std::stod(right->value);
+        case NodeKind::IMPORT:
+            return visit_import((Import*) node);
 
-                return new SingularMemoryValue(std::to_string(x + y), Type::FLOAT);
-            }
-            type_mismatch_error(op->left->token);
-        }
-        case TokenType::MINUS:
-        {   
-            if(left->type != Type::FLOAT || right->type != Type::FLOAT) {
-                type_mismatch_error(op->right->token);
-            }
-            double x = std::stod(left->value);
-            double y = std::stod(right->value);
+        case NodeKind::OBJECT_DIVE:
+            return visit_object_dive((ObjectDive*) node);
 
-            return new SingularMemoryValue(std::to_string(x - y), Type::FLOAT);
-        }
-        case TokenType::DIV:
-        {
-            if(left->type != Type::FLOAT || right->type != Type::FLOAT) {
-                type_mismatch_error(op->right->token);
-            }
-            double x = std::stod(left->value);
-            double y = std::stod(right->value);
+        case NodeKind::PROBE:
+            return visit_probe((Probe*) node);
 
-            return new SingularMemoryValue(std::to_string(x / y), Type::FLOAT);
-        }
-        case TokenType::MULT:
-        {
-            if(left->type != Type::FLOAT || right->type != Type::FLOAT) {
-                type_mismatch_error(op->right->token);
-            }
-            double x = std::stod(left->value);
-            double y = std::stod(right->value);
+        default:
+            break;
+    }
 
-            return new SingularMemoryValue(std::to_string(x * y), Type::FLOAT);
-        }
-        case TokenType::INT_DIV:
-        {
-            if(left->type != Type::FLOAT || right->type != Type::FLOAT) {
-                type_mismatch_error(op->right->token);
-            }
+    std::string message = "Unknown AST branch.";
+    int line = node->token->line;
+    int column = node->token->column;
+    std::string file_path = node->token->file;
+    Error(file_path, line, column, message).cast();
+    return TaggedValue();
+}
 
-            int x = std::stoi(left->value);
-            int y = std::stoi(right->value);
+TaggedValue Interpreter::visit_binary_op(BinaryOperator* op) {
+    TaggedValue left = visit(op->left);
 
-            return new SingularMemoryValue(std::to_string(x / y), Type::FLOAT);
-        }
-        case TokenType::MODULO:
-        {
-            if(left->type != Type::FLOAT || right->type != Type::FLOAT) {
-                type_mismatch_error(op->right->token);
-            }
+    temporaries.push_back(left);
+    TaggedValue right = visit(op->right);
+    temporaries.pop_back();
 
-            double x = std::stod(left->value);
-            double y = std::stod(right->value);
-            return new SingularMemoryValue(std::to_string(fmod(x, y)), Type::FLOAT);
-        }
-    }
+    return Operations::binary_op(op->op->type, left, right, op->left->token, op->right->token);
 }
 
-SingularMemoryValue* Interpreter::visit_unary_op(UnaryOperator* op) {
-    SingularMemoryValue* expr = (SingularMemoryValue*) visit(op->expr);
+TaggedValue Interpreter::visit_unary_op(UnaryOperator* op) {
+    TaggedValue expr = visit(op->expr);
 
     if(op->op->type_of(TokenType::MINUS)) {
-        if(expr->type == Type::FLOAT) {
-
-            double value = std::stod(expr->value);
-            return new SingularMemoryValue(std::to_string(-value), Type::FLOAT);
-
-        } else {
-            type_mismatch_error(op->expr->token);
-        }
-    } 
+        return Operations::unary_minus(expr, op->expr->token);
+    }
     return expr;
 }
 
-SingularMemoryValue* Interpreter::visit_value(Value* val) {
-    Type type;
+TaggedValue Interpreter::visit_value(Value* val) {
+    switch(val->token->type) {
+        case TokenType::FLOAT:
+            return TaggedValue(val->number);
 
-    if(val->token->type_of(TokenType::FLOAT)) {
-        type = Type::FLOAT;
+        case TokenType::INT:
+            return TaggedValue(val->integer);
 
-    } else if(val->token->type_of(TokenType::BOOLEAN)) {
-        type = Type::BOOLEAN;
+        case TokenType::BOOLEAN:
+            return TaggedValue(val->value == Values::TRUE);
 
-    } else if(val->token->type_of(TokenType::STRING)) {
-        type = Type::STRING;
+        case TokenType::STRING:
+            return TaggedValue(heap.track(new String(val->value)));
 
-    } else if(val->token->type_of(TokenType::NONE)) {
-        type = Type::NONE;
+        default:
+            return TaggedValue::none();
     }
-
-    return new SingularMemoryValue(val->value, type);
 }
 
-SingularMemoryValue* Interpreter::visit_compare(Compare* c) {
+TaggedValue Interpreter::visit_compare(Compare* c) {
+    TaggedValue left_value = visit(c->comparables[0]);
+
     for(int i = 0; i < c->operators.size(); i++) {
         Token* op = c->operators.at(i);
-        AST* left = c->comparables[i];
-        AST* right = c->comparables[i + 1];
 
-        SingularMemoryValue* left_memory_value = (SingularMemoryValue*) visit(left);
-        SingularMemoryValue* right_memory_value = (SingularMemoryValue*) visit(right);
-
-        std::string left_value = left_memory_value->value;
-        std::string right_value = right_memory_value->value;
-
-        if(op->type_of(TokenType::EQUALS)) {
-            if(left_memory_value->type == Type::FLOAT && right_memory_value->type == Type::FLOAT) {
-                double left_val = std::stod(left_value);
-                double right_val = std::stod(right_value);
-
-                if(left_val != right_val) {
-                    return new SingularMemoryValue(Values::FALSE, Type::BOOLEAN);
-                }
-            } else if(left_value != right_value) {
-                return new SingularMemoryValue(Values::FALSE, Type::BOOLEAN);
-            }
-        } else if(op->type_of(TokenType::NOT_EQUALS)) {
-            if(left_memory_value->type == Type::FLOAT && right_memory_value->type == Type::FLOAT) {
-                double left_val = std::stod(left_value);
-                double right_val = std::stod(right_value);
-
-                if(left_val == right_val) {
-                    return new SingularMemoryValue(Values::FALSE, Type::BOOLEAN);
-                }
-            } else if(left_value == right_value) {
-                return new SingularMemoryValue(Values::FALSE, Type::BOOLEAN);
-            }
-        } else if(op->type_of(TokenType::MORE_OR_EQ)) {
-            if(left_memory_value->type == Type::FLOAT && right_memory_value->type == Type::FLOAT) {
-                double left_val = std::stod(left_value);
-                double right_val = std::stod(right_value);
-
-                if(left_val < right_val) {
-                    return new SingularMemoryValue(Values::FALSE, Type::BOOLEAN);
-                }
-            } else {
-                type_mismatch_error(left->token);
-            }
-        } else if(op->type_of(TokenType::LESS_OR_EQ)) {
-            if(left_memory_value->type == Type::FLOAT && right_memory_value->type == Type::FLOAT) {
-                double left_val = std::stod(left_value);
-                double right_val = std::stod(right_value);
-
-                if(left_val > right_val) {
-                    return new SingularMemoryValue(Values::FALSE, Type::BOOLEAN);
-                }
-            } else {
-                type_mismatch_error(left->token);
-            }
-        } else if(op->type_of(TokenType::LESS)) {
-            if(left_memory_value->type == Type::FLOAT && right_memory_value->type == Type::FLOAT) {
-                double left_val = std::stod(left_value);
-                double right_val = std::stod(right_value);
+        temporaries.push_back(left_value);
+        TaggedValue right_value = visit(c->comparables[i + 1]);
+        temporaries.pop_back();
 
-                if(left_val >= right_val) {
-                    return new SingularMemoryValue(Values::FALSE, Type::BOOLEAN);
-                }
-            } else {
-                type_mismatch_error(left->token);
-            }
-        } else if(op->type_of(TokenType::MORE)) {
-            if(left_memory_value->type == Type::FLOAT && right_memory_value->type == Type::FLOAT) {
-                double left_val = std::stod(left_value);
-                double right_val = std::stod(right_value);
-
-                if(left_val <= right_val) {
-                    return new SingularMemoryValue(Values::FALSE, Type::BOOLEAN);
-                }
-            } else {
-                type_mismatch_error(left->token);
-            }
+        if(!Operations::compare(op->type, left_value, right_value, c->comparables[i]->token)) {
+            return TaggedValue(false);
         }
-    }
-    return new SingularMemoryValue(Values::TRUE, Type::BOOLEAN);
-}
 
-MemoryValue* Interpreter::visit_compound(Compound* comp) {
-    if(memory_block->memory_level == 0) {
-        enter_new_memory_block();
+        left_value = right_value;
     }
+    return TaggedValue(true);
+}
 
+TaggedValue Interpreter::visit_compound(Compound* comp) {
     for(AST* node : comp->children) {
-        if(Return* ret = dynamic_cast<Return*>(node)) {
+        if(node->kind == NodeKind::RETURN) {
+            Return* ret = (Return*) node;
+
             if(comp->inside_func) {
-                MemoryValue* return_value = visit_return(ret);
-                leave_memory_block();
+                TaggedValue return_value = visit_return(ret);
+                returning = true;
                 return return_value;
             }
 
@@ -326,192 +208,254 @@ MemoryValue* Interpreter::visit_compound(Compound* comp) {
             SyntaxError(file_path, line, column, message).cast();
         }
 
-        MemoryValue* value = visit(node);
+        heap.safepoint();
+        TaggedValue value = visit(node);
 
-        if(comp->inside_func && value != NULL) {
-            leave_memory_block();
+        if(returning) {
             return value;
-        } 
+        }
     }
 
-    leave_memory_block();
-    if(memory_block->memory_level == 1) {
-        Memory* object_memory = memory_block;
-        return new Object(object_memory);
+    return TaggedValue();
+}
+
+TaggedValue Interpreter::visit_block(Compound* comp) {
+    if(comp->scope == NULL) {
+        return visit(comp);
     }
 
-    return NULL;
+    enter_new_memory_block(comp->scope);
+    TaggedValue value = visit(comp);
+    leave_memory_block();
+
+    return value;
 }
 
-MemoryValue* Interpreter::visit_assign(Assign* assign) {
+TaggedValue Interpreter::visit_assign(Assign* assign) {
     AST* left = assign->left;
 
-    if(Variable* var = dynamic_cast<Variable*>(left)) {
-        std::string var_name = var->value;
-        memory_block->put(var_name, visit(assign->right));
+    if(left->kind == NodeKind::VARIABLE) {
+        Variable* var = (Variable*) left;
+        TaggedValue value = visit(assign->right);
+        Memory* memory = memory_block->up(var->depth);
 
-    } else if(ArrayAccess* arr_acc = dynamic_cast<ArrayAccess*>(left)) {
-        Array* arr = (Array*) visit(arr_acc->array);
+        memory->slots[var->slot] = value;
 
-        SingularMemoryValue* index = (SingularMemoryValue*) visit(arr_acc->index);
-        if(index->type != Type::FLOAT) {
-            type_mismatch_error(arr_acc->index->token);
+        if(var->depth > 0) {
+            heap.write_barrier(memory);
         }
 
-        MemoryValue* new_val = visit(assign->right);
-        arr->elements.at(std::stoi(index->value)) = new_val;
+    } else if(left->kind == NodeKind::ARRAY_ACCESS) {
+        ArrayAccess* arr_acc = (ArrayAccess*) left;
+        TaggedValue arr = visit(arr_acc->array);
+        temporaries.push_back(arr);
+
+        TaggedValue index = visit(arr_acc->index);
+        temporaries.push_back(index);
+
+        TaggedValue new_val = visit(assign->right);
+        temporaries.resize(temporaries.size() - 2);
+
+        Operations::array_set(arr, index, new_val, arr_acc->array->token, arr_acc->index->token);
+
+    } else if(left->kind == NodeKind::OBJECT_DIVE) {
+        ObjectDive* dive = (ObjectDive*) left;
+        TaggedValue object = visit(dive->parent);
+
+        temporaries.push_back(object);
+        TaggedValue value = visit(assign->right);
+        temporaries.pop_back();
+
+        Operations::member_set(object, dive->cache, value, dive->child->token);
     }
 
-    return NULL;
+    return TaggedValue();
 }
 
-MemoryValue* Interpreter::visit_variable(Variable* var) {
-    MemoryValue* val = memory_block->get(var->value, false);
+TaggedValue Interpreter::visit_variable(Variable* var) {
+    TaggedValue val = memory_block->up(var->depth)->slots[var->slot];
 
-    if(val != NULL) {
-        return val;
-    } else {
+    if(val.is_empty()) {
         std::string message = "Variable has not been initialized.";
         int line = var->token->line;
         int column = var->token->column;
         std::string file_path = var->token->file;
         NameError(file_path, line, column, message).cast();
     }
+
+    return val;
 }
 
-MemoryValue* Interpreter::visit_no_operator(NoOperator* no_op) {
-    return NULL;
+TaggedValue Interpreter::visit_no_operator(NoOperator* no_op) {
+    return TaggedValue();
 }
 
-SingularMemoryValue* Interpreter::visit_double_condition(DoubleCondition* cond) {
-    std::string left_value = ((SingularMemoryValue*) visit(cond->left))->value;
-    std::string right_value = ((SingularMemoryValue*) visit(cond->right))->value;
+TaggedValue Interpreter::visit_double_condition(DoubleCondition* cond) {
+    bool left_value = visit(cond->left).is_true();
 
-    if(cond->token->type_of(TokenType::AND)) {
-        if(left_value == Values::TRUE && right_value == Values::TRUE) {
-            return new SingularMemoryValue(Values::TRUE, Type::BOOLEAN);
-        } else {
-            return new SingularMemoryValue(Values::FALSE, Type::BOOLEAN);
-        }
+    if(cond->token->type_of(TokenType::AND) ? !left_value : left_value) {
+        return TaggedValue(left_value);
+    }
 
-    } else if(cond->token->type_of(TokenType::OR)) {
-        if(left_value == Values::TRUE || right_value == Values::TRUE) {
-            return new SingularMemoryValue(Values::TRUE, Type::BOOLEAN);
-        } else {
-            return new SingularMemoryValue(Values::FALSE, Type::BOOLEAN);
+    return TaggedValue(visit(cond->right).is_true());
+}
+
+TaggedValue Interpreter::visit_negation(Negation* neg) {
+    return Operations::negate(visit(neg->statement), neg->statement->token);
+}
+
+TaggedValue Interpreter::visit_var_declaration(VariableDeclaration* decl) {
+    for(size_t i = 0; i < decl->variables.size(); i++) {
+        TaggedValue value;
+
+        if(i < decl->assignments.size()) {
+            value = visit(decl->assignments[i]->right);
         }
+
+        memory_block->slots[decl->variables[i]->slot] = value;
     }
+
+    return TaggedValue();
 }
 
-SingularMemoryValue* Interpreter::visit_negation(Negation* neg) {
-    SingularMemoryValue* value = (SingularMemoryValue*) visit(neg->statement);
+TaggedValue Interpreter::visit_if_condition(IfCondition* cond) {
+    std::vector<IfCondition*> branches = { cond };
+    branches.insert(branches.end(), cond->elses.begin(), cond->elses.end());
 
-    if(value->type != Type::BOOLEAN) {
-        type_mismatch_error(neg->statement->token);
+    for(IfCondition* branch : branches) {
+        if(branch->condition == NULL || visit(branch->condition).is_true()) {
+            return visit_block(branch->statement);
+        }
     }
+    return TaggedValue();
+}
 
-    if(value->value == Values::TRUE) {
-        return new SingularMemoryValue(Values::FALSE, Type::BOOLEAN);
-    } else if(value->value == Values::FALSE) {
-        return new SingularMemoryValue(Values::TRUE, Type::BOOLEAN);
-    }
+TaggedValue Interpreter::visit_print(Print* print) {
+    TaggedValue printable_value = visit(print->printable);
+
+    printable_value.write(output.buffer);
+    output.end_line();
+
+    return TaggedValue();
 }
 
-MemoryValue* Interpreter::visit_var_declaration(VariableDeclaration* decl) {
-    for(Assign* assignment : decl->assignments) {
-        visit(assignment);
+TaggedValue Interpreter::visit_array_init(ArrayInit* array_init) {
+    size_t base = temporaries.size();
+
+    for(AST* el : array_init->elements) {
+        temporaries.push_back(visit(el));
     }
 
-    return NULL;
+    std::vector<TaggedValue> elements(temporaries.begin() + base, temporaries.end());
+    temporaries.resize(base);
+
+    return TaggedValue(heap.track(new Array(elements)));
 }
 
-MemoryValue* Interpreter::visit_if_condition(IfCondition* cond) {
-    AST* condition = cond->condition;
-    Compound* statement = cond->statement;
+TaggedValue Interpreter::visit_array_access(ArrayAccess* access) {
+    TaggedValue arr = visit(access->array);
 
-    std::string cond_value = ((SingularMemoryValue*) visit(condition))->value;
+    temporaries.push_back(arr);
+    TaggedValue index = visit(access->index);
+    temporaries.pop_back();
 
-    MemoryValue* return_val = NULL;
+    return Operations::array_get(arr, index, access->array->token, access->index->token);
+}
 
-    if(cond_value == Values::TRUE) {
-        enter_new_memory_block();
-        return_val = visit(statement);
-    } else {
-        for(IfCondition* else_ : cond->elses) {
-            std::string else_cond_value = ((SingularMemoryValue*) visit(else_->condition))->value;
+TaggedValue Interpreter::visit_map_init(MapInit* map_init) {
+    size_t base = temporaries.size();
 
-            if(else_cond_value == Values::TRUE) {
-                enter_new_memory_block();
-                return visit(else_->statement);
-            }
-        }
+    for(size_t i = 0; i < map_init->keys.size(); i++) {
+        temporaries.push_back(visit(map_init->keys[i]));
+        temporaries.push_back(visit(map_init->values[i]));
     }
-    return return_val;
-}
 
-MemoryValue* Interpreter::visit_print(Print* print) {
-    MemoryValue* printable_value = visit(print->printable);
+    Map* map = heap.track(new Map());
+
+    for(size_t i = 0; i < map_init->keys.size(); i++) {
+        TaggedValue key = temporaries[base + 2 * i];
+        Operations::map_insert(map, key, temporaries[base + 2 * i + 1], map_init->keys[i]->token);
+    }
+    temporaries.resize(base);
 
-    std::cout << printable_value->str() << std::endl;
-    
-    return NULL;
+    return TaggedValue(map);
 }
 
-Array* Interpreter::visit_array_init(ArrayInit* array_init) {
-    std::vector<MemoryValue*> elements;
+TaggedValue Interpreter::visit_delete(Delete* del) {
+    ArrayAccess* target = del->target;
+    TaggedValue map = visit(target->array);
 
-    for(AST* el : array_init->elements) {
-        MemoryValue* element = visit(el);
-        elements.push_back(element);
-    }
+    temporaries.push_back(map);
+    TaggedValue key = visit(target->index);
+    temporaries.pop_back();
 
-    return new Array(elements);
+    Operations::map_delete(map, key, target->array->token, target->index->token);
+    return TaggedValue();
 }
 
-MemoryValue* Interpreter::visit_array_access(ArrayAccess* access) {
-    MemoryValue* arr = visit(access->array);
+TaggedValue Interpreter::visit_function_init(FunctionInit* func_init) {
+    memory_block->slots[func_init->slot] = TaggedValue(heap.track(new Function(func_init, NULL, memory_block)));
+    return TaggedValue();
+}
 
-    if(arr->type != Type::ARRAY) {
-        std::string message = "Given object is not an array.";
-        int line = access->array->token->line;
-        int column = access->array->token->column;
-        std::string file_path = access->array->token->file;
+TaggedValue Interpreter::visit_function_call(FunctionCall* func_call) {
+    size_t base = temporaries.size();
+    TaggedValue callee = push_call(func_call);
+    Token* token = func_call->function->token;
 
-        SyntaxError(file_path, line, column, message).cast();
+    if(callee.type == Type::NATIVE) {
+        return call_native(base, token);
     }
 
-    Array* array = (Array*) arr;
-    
-    MemoryValue* index = visit(access->index);
+    Function* function = (Function*) callee.ref;
+    check_depth(function, token);
 
-    if(index->type != Type::FLOAT) {
-        type_mismatch_error(access->index->token);
-    }
+    callers.push_back(memory_block);
+    calls.push_back({ function->func, token });
+    memory_block = bind_arguments(function, base);
 
-    SingularMemoryValue* _index = (SingularMemoryValue*) index;
-    int i = std::stoi(_index->value);
+    TaggedValue ret = visit(function->func->block);
+    returning = false;
 
-    if(i > array->elements.size() - 1) {
-        std::string message = "Index out of bounds.";
-        int line = access->index->token->line;
-        int column = access->index->token->column;
-        std::string file_path = access->index->token->file;
+    // A returned call left its function and arguments at base instead of
+    // being made, so it runs here in place of a nested C++ call.
+    while(tail_call != NULL) {
+        function = (Function*) temporaries[base].ref;
+        calls.back() = { function->func, tail_call->function->token };
+        tail_call = NULL;
 
-        SyntaxError(file_path, line, column, message).cast();
+        frame_pool.leave(memory_block);
+        memory_block = callers.back();
+        heap.safepoint();
+        memory_block = bind_arguments(function, base);
+
+        ret = visit(function->func->block);
+        returning = false;
     }
 
-    return array->elements.at(i);
-}
+    // A class body leaves behind the instance's members.
+    if(function->func->kind == NodeKind::CLASS_INIT) {
+        ret = TaggedValue(heap.track(new Object(memory_block, function->func->func_name)));
+    }
+
+    frame_pool.leave(memory_block);
+    memory_block = callers.back();
+    callers.pop_back();
+    calls.pop_back();
 
-Function* Interpreter::visit_function_init(FunctionInit* func_init) {
-    memory_block->put(func_init->func_name, new Function(func_init));
-    return NULL;
+    if(ret.is_empty()) {
+        return TaggedValue::none();
+    }
+
+    return ret;
 }
 
-MemoryValue* Interpreter::visit_function_call(FunctionCall* func_call) {
-    MemoryValue* func = visit(func_call->function);
+// Evaluates the callee and pushes it and the arguments onto temporaries.
+TaggedValue Interpreter::push_call(FunctionCall* func_call) {
+    TaggedValue func = visit(func_call->function);
+    int argc = func_call->params.size();
 
-    if(func->type != Type::FUNCTION) {
+    if(func.type != Type::FUNCTION && func.type != Type::NATIVE) {
         std::string message = "Given object is not a function.";
         int line = func_call->function->token->line;
         int column = func_call->function->token->column;
@@ -520,192 +464,224 @@ MemoryValue* Interpreter::visit_function_call(FunctionCall* func_call) {
         SyntaxError(file_path, line, column, message).cast();
     }
 
-    Function* function = (Function*) func;
-    enter_new_memory_block();
+    bool accepted;
 
-    VariableDeclaration* func_params = function->func->params;
-
-    if(func_params != NULL) {
-        visit(func_params);
+    if(func.type == Type::NATIVE) {
+        accepted = ((NativeFunction*) func.ref)->accepts(argc);
+    } else {
+        accepted = ((Function*) func.ref)->func->arity == argc;
+    }
 
-        if(func_params->variables.size() != func_call->params.size()) {
-            std::string message = "Inconsistent number of arguments.";
-            int line = func_call->function->token->line;
-            int column = func_call->function->token->column;
-            std::string file_path = func_call->function->token->file;
+    if(!accepted) {
+        std::string message = "Inconsistent number of arguments.";
+        Function* function = (Function*) func.ref;
 
-            SyntaxError(file_path, line, column, message).cast();
+        if(func.type == Type::FUNCTION && function->func->arity == 0) {
+            message = "Function " + function->func->func_name + " has no arguments, but " +
+            std::to_string(argc) + " were given.";
         }
 
-        for(int i = 0; i < func_params->variables.size(); i++) {
-            Variable* param = func_params->variables.at(i);
-            AST* actual_param = func_call->params.at(i);
-            
-            Assign* assign = new Assign(param, new Token(TokenType::ASSIGN, "="), actual_param);
-            visit(assign);
-        }
-    } else {
-        if(func_call->params.size() > 0) {
-            std::string message = "Function " + function->func->func_name + " has no arguments, but " + 
-            std::to_string(func_call->params.size()) + " were given.";
-
-            int line = func_call->function->token->line;
-            int column = func_call->function->token->column;
-            std::string file_path = func_call->function->token->file;
+        int line = func_call->function->token->line;
+        int column = func_call->function->token->column;
+        std::string file_path = func_call->function->token->file;
 
-            SyntaxError(file_path, line, column, message).cast();
-        }
+        SyntaxError(file_path, line, column, message).cast();
     }
 
+    temporaries.push_back(func);
+
+    for(AST* actual_param : func_call->params) {
+        temporaries.push_back(visit(actual_param));
+    }
 
-    MemoryValue* ret = visit(function->func->block);
+    return func;
+}
 
-    leave_memory_block();
+Memory* Interpreter::bind_arguments(Function* function, size_t base) {
+    Memory* block = frame_pool.enter(function->func->scope, function->closure);
 
-    if(ret == NULL) {
-        return new SingularMemoryValue(Values::NONE, Type::NONE);
+    for(int i = 0; i < function->func->arity; i++) {
+        block->slots[i] = temporaries[base + 1 + i];
     }
-    
-    return ret;
+    temporaries.resize(base);
+
+    return block;
 }
 
-MemoryValue* Interpreter::visit_return(Return* ret) {
-    return visit(ret->returnable);
+TaggedValue Interpreter::call_native(size_t base, Token* token) {
+    NativeFunction* native = (NativeFunction*) temporaries[base].ref;
+    int argc = temporaries.size() - base - 1;
+
+    TaggedValue result = native->code(temporaries.data() + base + 1, argc, token);
+    temporaries.resize(base);
+
+    return result;
 }
 
-MemoryValue* Interpreter::visit_while_loop(WhileLoop* while_loop) {
-    AST* condition = while_loop->condition;
-    Compound* statement = while_loop->statement;
+void Interpreter::check_depth(Function* function, Token* token) {
+    char here;
+    bool out_of_stack = (size_t) (stack_base - &here) > stack_budget;
 
-    std::string cond_value = ((SingularMemoryValue*) visit(condition))->value;
+    if(callers.size() < max_depth && !out_of_stack) {
+        return;
+    }
 
-    MemoryValue* return_val = NULL;
+    StackTrace trace;
+    trace.add(function->func->func_name, token);
 
-    while(cond_value == Values::TRUE) {
-        enter_new_memory_block();
-        return_val = visit(statement);
+    for(int i = calls.size() - 1; i >= 0; i--) {
+        trace.add(calls[i].first->func_name, calls[i].second);
+    }
+
+    std::string message = "Maximum recursion depth of " + std::to_string(max_depth) + " exceeded.\n";
 
-        cond_value = ((SingularMemoryValue*) visit(condition))->value;
-    } 
+    if(out_of_stack) {
+        message = "Native stack exhausted after " + std::to_string(callers.size()) + " nested calls.\n";
+    }
 
-    return return_val;
+    RecursionError(token->file, token->line, token->column, message + trace.str()).cast();
 }
 
-SingularMemoryValue* Interpreter::visit_cast_value(CastValue* cast) {
-    MemoryValue* memory_val = visit(cast->value);
+TaggedValue Interpreter::visit_return(Return* ret) {
+    if(ret->returnable->kind == NodeKind::FUNCTION_CALL) {
+        FunctionCall* func_call = (FunctionCall*) ret->returnable;
+        size_t base = temporaries.size();
 
-    if(SingularMemoryValue* memory_value = dynamic_cast<SingularMemoryValue*>(memory_val)) {
-        std::string value = memory_value->value;
-        Type type = memory_value->type;
+        if(push_call(func_call).type == Type::NATIVE) {
+            return call_native(base, func_call->function->token);
+        }
 
-        switch(cast->type->type) {
-            case TokenType::CAST_FLOAT:
-            {
-                int dots = 0;
+        tail_call = func_call;
+        return TaggedValue();
+    }
 
-                for(char c : value) {
-                    if(!isdigit(c) && c != '.') {
-                        value_error(cast->type);
-                    }
+    return visit(ret->returnable);
+}
 
-                    if(c == '.') {
-                        dots++;
+// The bounds are evaluated in the enclosing block and held on temporaries
+// until the loop's own block exists to keep them.
+TaggedValue Interpreter::visit_for_loop(ForLoop* for_loop) {
+    size_t base = temporaries.size();
+    temporaries.push_back(visit(for_loop->start));
 
-                        if(dots > 1) {
-                            value_error(cast->type);
-                        }
-                    }
-                }
-                std::string new_value = std::to_string(std::stod(value));
-                return new SingularMemoryValue(new_value, Type::FLOAT);
-            }
-            case TokenType::CAST_INT:
-            {
-                int dots = 0;
-
-                for(char c : value) {
-                    if(!isdigit(c) && c != '.') {
-                        value_error(cast->type);
-                    }
-
-                    if(c == '.') {
-                        dots++;
-
-                        if(dots > 1) {
-                            value_error(cast->type);
-                        }
-                    }
-                }
-                std::string new_value = std::to_string(std::stoi(value));
-                return new SingularMemoryValue(new_value, Type::FLOAT);
-            }
-            case TokenType::CAST_STRING:
-            {
-                return new SingularMemoryValue(value, Type::STRING);
-            }
-            case TokenType::CAST_BOOL:
-            {
-                if(value == Values::TRUE || value == Values::FALSE) {
-                    return new SingularMemoryValue(value, Type::BOOLEAN);
-                }
+    if(for_loop->end != NULL) {
+        temporaries.push_back(visit(for_loop->end));
+        temporaries.push_back(for_loop->step != NULL ? visit(for_loop->step) : TaggedValue((int64_t) 1));
+    }
+
+    enter_new_memory_block(for_loop->scope);
+    std::vector<TaggedValue>& slots = memory_block->slots;
+    TaggedValue return_val;
+
+    if(for_loop->end != NULL) {
+        TaggedValue& var = slots[0];
+        TaggedValue& end = slots[1];
+        TaggedValue& step = slots[2];
+        Token* token = for_loop->token;
+
+        var = temporaries[base];
+        end = temporaries[base + 1];
+        step = temporaries[base + 2];
+        temporaries.resize(base);
 
-                value_error(cast->type);
+        Operations::check_range(var, end, step, token);
+
+        for(; Operations::range_continues(var, end, step, token); Operations::range_step(var, step, token)) {
+            return_val = visit_block(for_loop->statement);
+
+            if(returning) {
+                break;
             }
         }
-    } else if(Array* array = dynamic_cast<Array*>(memory_val)) {
-        switch(cast->type->type) {
-            case TokenType::CAST_STRING:
-            {
-                return new SingularMemoryValue(array->str(), Type::STRING);
-            }
-            case TokenType::CAST_INT:
-            {
-                int length = array->elements.size();
-                return new SingularMemoryValue(std::to_string(length), Type::FLOAT);
-            }
-            case TokenType::CAST_FLOAT:
-            {
-                double length = array->elements.size();
-                return new SingularMemoryValue(std::to_string(length), Type::FLOAT);
+    } else {
+        slots[1] = Operations::iterable(temporaries[base], for_loop->start->token);
+        temporaries.resize(base);
+
+        if(slots[1].type == Type::HANDLE) {
+            Handle* handle = (Handle*) slots[1].ref;
+
+            while(handle->next(slots[0])) {
+                return_val = visit_block(for_loop->statement);
+
+                if(returning) {
+                    break;
+                }
             }
-            case TokenType::CAST_BOOL:
-            {
-                int length = array->elements.size();
-                if(length > 0) {
-                    return new SingularMemoryValue(Values::TRUE, Type::BOOLEAN);
+        } else {
+            Array* array = (Array*) slots[1].ref;
+
+            for(size_t i = 0; i < array->length(); i++) {
+                slots[0] = array->get(i);
+                return_val = visit_block(for_loop->statement);
+
+                if(returning) {
+                    break;
                 }
-                return new SingularMemoryValue(Values::FALSE, Type::BOOLEAN);
             }
         }
     }
 
-    value_error(cast->type);
+    leave_memory_block();
+    return returning ? return_val : TaggedValue();
+}
+
+TaggedValue Interpreter::visit_while_loop(WhileLoop* while_loop) {
+    AST* condition = while_loop->condition;
+    Compound* statement = while_loop->statement;
+
+    while(visit(condition).is_true()) {
+        TaggedValue return_val = visit_block(statement);
+
+        if(returning) {
+            return return_val;
+        }
+    }
+
+    return TaggedValue();
+}
+
+TaggedValue Interpreter::visit_cast_value(CastValue* cast) {
+    return Operations::cast(visit(cast->value), cast->type);
 }
 
-Object* Interpreter::visit_import(Import* import) {
+TaggedValue Interpreter::visit_import(Import* import) {
     std::string name = import->name;
     std::string path = import->path;
 
     if(import->token->type_of(TokenType::BUILT_IN_LIB)) {
-        std::cout << "Built in lib" << std::endl;
-        return NULL;
-    } 
+        memory_block->slots[import->slot] = module_registry.builtin(import->token);
+        return TaggedValue();
+    }
+
+    std::string module_path = directory + path;
+    TaggedValue object = module_registry.find(get_canonical_path(module_path), import->token);
 
-    Object* object = (Object*) Interpreter().evaluate(directory + path);
+    if(object.is_empty()) {
+        object = Interpreter().evaluate(module_path);
+    }
 
-    memory_block->put(name, object);
+    memory_block->slots[import->slot] = object;
+    return TaggedValue();
 }
 
-MemoryValue* Interpreter::visit_object_dive(ObjectDive* dive) {
-    MemoryValue* parent = visit(dive->parent);
-    if(Object* object = dynamic_cast<Object*>(parent)) {
-        Memory* enclosing_memory = memory_block;
-        memory_block = object->object_memory;
+TaggedValue Interpreter::visit_object_dive(ObjectDive* dive) {
+    TaggedValue parent = visit(dive->parent);
 
-        MemoryValue* value = visit(dive->child);
+    if(parent.type == Type::OBJECT) {
+        Object* object = (Object*) parent.ref;
+        Memory* memory = object->object_memory;
+        int slot = dive->cache->lookup(memory->layout);
 
-        memory_block = enclosing_memory;
-        return value;
+        if(slot == -1 || memory->slots[slot].is_empty()) {
+            std::string message = "Variable has not been initialized.";
+            Token* token = dive->child->token;
+            NameError(token->file, token->line, token->column, message).cast();
+        }
+        return memory->slots[slot];
+    }
+
+    if(parent.type == Type::MAP) {
+        return Operations::map_member(parent, dive->child->value, dive->child->token);
     }
 
     std::string message = "Variable is not object type.";
@@ -714,25 +690,98 @@ MemoryValue* Interpreter::visit_object_dive(ObjectDive* dive) {
     std::string file_path = dive->token->file;
 
     ValueError(file_path, line, column, message).cast();
+    return TaggedValue();
 }
 
-std::string get_dir_from_path(std::string path) {
-    std::string directory;
-    const size_t last_slash_index = path.find_last_of('\\/');
-    if (std::string::npos != last_slash_index) {
-        directory = path.substr(0, last_slash_index + 1);
+// When counting, every run of the probed node is counted and timed, the
+// time including any calls it makes. When sampling, a pending sample goes
+// to the innermost statement that was running when the timer fired: the
+// one enclosing this probe if it fires before the statement starts, this
+// one if it fires before the statement ends.
+TaggedValue Interpreter::visit_probe(Probe* probe) {
+    if(profiler.counting) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        probe->active++;
+        TaggedValue value = visit_probed(probe);
+
+        if(--probe->active == 0) {
+            probe->nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+        probe->count++;
+        return value;
+    }
+
+    Probe* enclosing = statement;
+
+    if(Profiler::tick && enclosing != NULL) {
+        sample(enclosing);
+    }
+
+    statement = probe;
+    TaggedValue value = visit_probed(probe);
+
+    if(Profiler::tick) {
+        sample(probe);
     }
-    return directory;
+
+    statement = enclosing;
+    return value;
 }
 
-MemoryValue* Interpreter::evaluate(std::string path) {
-    this->directory = get_dir_from_path(path);
+// A probed return is run the way visit_compound runs a bare one.
+TaggedValue Interpreter::visit_probed(Probe* probe) {
+    if(probe->statement->kind == NodeKind::RETURN) {
+        TaggedValue value = visit_return((Return*) probe->statement);
+        returning = true;
+        return value;
+    }
+    return visit(probe->statement);
+}
 
-    Lexer* lexer = new Lexer(path);
-    Parser* parser = new Parser(lexer);
+void Interpreter::sample(Probe* probe) {
+    profiler.stack.assign(1, module_name);
 
-    AST* tree = parser->parse();
-    semantic_analyzer->visit(tree);
-    return visit(tree);
+    for(std::pair<FunctionInit*, Token*>& call : calls) {
+        profiler.stack.push_back(&call.first->func_name);
+    }
+    profiler.sample(probe->token);
 }
 
+TaggedValue Interpreter::evaluate(std::string path) {
+    // Leave room below the budget for the deepest expression a single call
+    // may evaluate, and for reporting the error.
+    if(stack_base == NULL) {
+        char base;
+        rlimit limit;
+        getrlimit(RLIMIT_STACK, &limit);
+
+        size_t size = limit.rlim_cur == RLIM_INFINITY ? (size_t) 1 << 30 : limit.rlim_cur;
+
+        stack_base = &base;
+        stack_budget = size - std::min(size / 4, (size_t) 1 << 20);
+    }
+
+    this->directory = get_dir_from_path(path);
+
+    std::string canonical_path = get_canonical_path(path);
+    module_registry.begin(canonical_path);
+
+    AST* tree = module_registry.parse(path);
+
+    if(profiler.sampling || profiler.counting) {
+        module_name = profiler.module_name(path);
+        profiler.instrument(tree);
+    }
+
+    Compound* program = (Compound*) tree;
+    memory_block = heap.track(new Memory(program->scope, NULL));
+    visit(program);
+
+    heap.write_barrier(memory_block);
+
+    TaggedValue module = TaggedValue(heap.track(new Object(memory_block)));
+    module_registry.finish(canonical_path, module);
+
+    return module;
+}
@@ -7,54 +7,101 @@
 #include "../lexer/Lexer.h"
 #include "../parser/Parser.h"
 #include "Memory.h"
+#include "Heap.h"
+#include "FramePool.h"
+#include "ModuleRegistry.h"
+#include "Operations.h"
 #include "SemanticAnalyzer.h"
+#include "Profiler.h"
 #include "../utils/Values.h"
 #include "../utils/Error.h"
+#include "../utils/Path.h"
+#include "../utils/StackTrace.h"
 
-class Interpreter {
+class Interpreter : public RootSet {
     public:
         Interpreter();
+        ~Interpreter();
         
-        MemoryValue* evaluate(std::string path);
+        TaggedValue evaluate(std::string path);
 
         Memory* memory_block;
 
         std::string directory;
+
+        // Deepest Misty call stack allowed before a RecursionError. Calls
+        // recurse on the native stack here, which may run out first.
+        inline static size_t max_depth = 10000000;
     
     private:
-        SemanticAnalyzer* semantic_analyzer;
-
-        MemoryValue* visit(AST* node);
-        MemoryValue* visit_binary_op(BinaryOperator* op);
-        MemoryValue* visit_compound(Compound* comp);
-        MemoryValue* visit_assign(Assign* assign);
-        MemoryValue* visit_variable(Variable* var);
-        MemoryValue* visit_no_operator(NoOperator* no_op);
-        MemoryValue* visit_var_declaration(VariableDeclaration* decl);
-        MemoryValue* visit_if_condition(IfCondition* cond);
-        MemoryValue* visit_print(Print* print);
-        MemoryValue* visit_array_access(ArrayAccess* access);
-        MemoryValue* visit_function_call(FunctionCall* func_call);
-        MemoryValue* visit_return(Return* ret);
-        MemoryValue* visit_while_loop(WhileLoop* while_loop);
-        MemoryValue* visit_object_dive(ObjectDive* dive);
+        bool returning;
+
+        // Set by a return whose value is a call. The call's function and
+        // arguments are left on temporaries for visit_function_call to run.
+        FunctionCall* tail_call;
+
+        // Values held in C++ locals while a sub-expression that may call a
+        // function is evaluated, and the memory of every suspended caller.
+        // Both are GC roots.
+        std::vector<TaggedValue> temporaries;
+        std::vector<Memory*> callers;
+
+        // The function and call site of every active call, for stack traces.
+        std::vector<std::pair<FunctionInit*, Token*>> calls;
+
+        // The module's name in profiles, and the innermost statement
+        // running, when profiling.
+        const std::string* module_name;
+        Probe* statement;
+
+        // Where the first evaluate() started on the native stack, and how
+        // much of the stack calls may use before a RecursionError.
+        inline static char* stack_base = NULL;
+        inline static size_t stack_budget = 0;
+
+        void trace_roots(Heap* heap) override;
+
+        TaggedValue visit(AST* node);
+        TaggedValue visit_binary_op(BinaryOperator* op);
+        TaggedValue visit_compound(Compound* comp);
+        TaggedValue visit_assign(Assign* assign);
+        TaggedValue visit_variable(Variable* var);
+        TaggedValue visit_no_operator(NoOperator* no_op);
+        TaggedValue visit_var_declaration(VariableDeclaration* decl);
+        TaggedValue visit_if_condition(IfCondition* cond);
+        TaggedValue visit_print(Print* print);
+        TaggedValue visit_array_access(ArrayAccess* access);
+        TaggedValue visit_delete(Delete* del);
+        TaggedValue visit_function_call(FunctionCall* func_call);
+        TaggedValue visit_return(Return* ret);
+        TaggedValue visit_while_loop(WhileLoop* while_loop);
+        TaggedValue visit_for_loop(ForLoop* for_loop);
+        TaggedValue visit_object_dive(ObjectDive* dive);
+        TaggedValue visit_probe(Probe* probe);
+        TaggedValue visit_probed(Probe* probe);
+        void sample(Probe* probe);
         
-        Array* visit_array_init(ArrayInit* array_init);
-        Function* visit_function_init(FunctionInit* func_init);
-        Object* visit_import(Import* import);
-
-        SingularMemoryValue* visit_unary_op(UnaryOperator* op);
-        SingularMemoryValue* visit_value(Value* val);
-        SingularMemoryValue* visit_compare(Compare* c);
-        SingularMemoryValue* visit_double_condition(DoubleCondition* cond);
-        SingularMemoryValue* visit_negation(Negation* neg);
-        SingularMemoryValue* visit_cast_value(CastValue* cast);
-
-        void enter_new_memory_block();
-        void leave_memory_block();
+        TaggedValue visit_array_init(ArrayInit* array_init);
+        TaggedValue visit_map_init(MapInit* map_init);
+        TaggedValue visit_function_init(FunctionInit* func_init);
+        TaggedValue visit_import(Import* import);
+
+        TaggedValue visit_unary_op(UnaryOperator* op);
+        TaggedValue visit_value(Value* val);
+        TaggedValue visit_compare(Compare* c);
+        TaggedValue visit_double_condition(DoubleCondition* cond);
+        TaggedValue visit_negation(Negation* neg);
+        TaggedValue visit_cast_value(CastValue* cast);
 
-        void type_mismatch_error(Token* token);
-        void value_error(Token* token);
+        TaggedValue visit_block(Compound* comp);
+
+        TaggedValue push_call(FunctionCall* func_call);
+        Memory* bind_arguments(Function* function, size_t base);
+        TaggedValue call_native(size_t base, Token* token);
+        void check_depth(Function* function, Token* token);
+
+        void enter_new_memory_block(SymbolTable* scope);
+        void leave_memory_block();
 };
 
 #endif
\ No newline at end of file
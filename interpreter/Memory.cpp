@@ -1,28 +1,93 @@
 #include "Memory.h"
+#include "../utils/Values.h"
+#include <charconv>
+#include <cstring>
+#include <cmath>
+#include <functional>
 
 MemoryValue::~MemoryValue() = default;
 
-Memory::Memory(int memory_level, Memory* enclosing_memory_block) {
-    this->memory_level = memory_level;
+TaggedValue::TaggedValue(MemoryValue* ref) {
+    this->type = ref->type;
+    this->ref = ref;
+}
+
+std::string TaggedValue::str() {
+    std::string result;
+    write(result);
+    return result;
+}
+
+void TaggedValue::write(std::string& out) {
+    char buffer[32];
+    std::to_chars_result result;
+
+    switch(type) {
+        case Type::FLOAT:
+            if(number > -1e16 && number < 1e16 && number == (int64_t) number) {
+                result = std::to_chars(buffer, buffer + sizeof(buffer), (int64_t) number);
+            } else {
+                result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+            }
+            out.append(buffer, result.ptr);
+            break;
+
+        case Type::INT:
+            result = std::to_chars(buffer, buffer + sizeof(buffer), integer);
+            out.append(buffer, result.ptr);
+            break;
+
+        case Type::BOOLEAN:
+            out += boolean ? Values::TRUE : Values::FALSE;
+            break;
+
+        case Type::NONE:
+            out += Values::NONE;
+            break;
+
+        case Type::EMPTY:
+            break;
+
+        default:
+            ref->write(out);
+    }
+}
+
+Memory::Memory(SymbolTable* layout, Memory* enclosing_memory_block) {
+    this->layout = layout;
+    this->slots.resize(layout->size());
     this->enclosing_memory_block = enclosing_memory_block;
 }
 
+void Function::trace(Heap* heap) {
+    heap->mark(closure);
+}
+
 std::string Memory::str() {
     std::string result = "Symbols: \n";
 
-    std::map<std::string, MemoryValue*>::iterator it;
+    std::map<std::string, Symbol*>::iterator it;
 
-    for(it = values.begin(); it != values.end(); it++) {
+    for(it = layout->symbols.begin(); it != layout->symbols.end(); it++) {
         result += "Name: " + it->first + ", Value: ";
 
-        if(SingularMemoryValue* sing = dynamic_cast<SingularMemoryValue*>(it->second)) {
-            result += sing->value;
-        } else if(Array* arr = dynamic_cast<Array*>(it->second)) {
-            result += "array";
-        } else if(Function* func = dynamic_cast<Function*>(it->second)) {
-            result += "function";
-        } else if(Object* object = dynamic_cast<Object*>(it->second)) {
-            result += "object";
+        TaggedValue value = slots[it->second->slot];
+
+        switch(value.type) {
+            case Type::ARRAY:
+                result += "array";
+                break;
+            case Type::MAP:
+                result += "map";
+                break;
+            case Type::FUNCTION:
+                result += "function";
+                break;
+            case Type::OBJECT:
+                result += "object";
+                break;
+            default:
+                result += value.str();
         }
 
         result += "\n";
@@ -31,54 +96,344 @@ std::string Memory::str() {
     return result;
 }
 
-MemoryValue* Memory::get(std::string name, bool only_this_block) {
-    if(values.find(name) != values.end()) {
-        return values.find(name)->second;
-    }
+std::string String::str() {
+    return value;
+}
 
-    if(enclosing_memory_block != NULL && !only_this_block) {
-        return enclosing_memory_block->get(name, false);
+void String::write(std::string& out) {
+    out += value;
+}
+
+std::string Function::str() {
+    if(func->kind == NodeKind::CLASS_INIT) {
+        return "class " + func->func_name;
     }
+    return "function " + func->func_name;
+}
 
-    return NULL;
+std::string NativeFunction::str() {
+    return "function " + name;
 }
 
-void Memory::put(std::string name, MemoryValue* val) {
-    Memory* scope = this;
+Array::Array(std::vector<TaggedValue> elements)
+: MemoryValue(Type::ARRAY) {
+    this->packing = elements.empty() ? Type::EMPTY : elements[0].type;
 
-    while(scope->get(name, true) == NULL) {
-        if(scope->memory_level != 1) {
-            scope = scope->enclosing_memory_block;
-        } else {
+    for(TaggedValue& element : elements) {
+        if(element.type != packing) {
+            packing = Type::EMPTY;
             break;
         }
     }
 
-    scope->values[name] = val;
+    switch(packing) {
+        case Type::FLOAT:
+            for(TaggedValue& element : elements) {
+                numbers.push_back(element.number);
+            }
+            break;
+
+        case Type::INT:
+            for(TaggedValue& element : elements) {
+                integers.push_back(element.integer);
+            }
+            break;
+
+        default:
+            packing = Type::EMPTY;
+            this->elements = elements;
+    }
 }
 
-std::string SingularMemoryValue::str() {
-    return value;
+void Array::set(size_t index, TaggedValue value) {
+    if(packing == Type::FLOAT && value.type == Type::FLOAT) {
+        numbers[index] = value.number;
+        return;
+    }
+
+    if(packing == Type::INT && value.type == Type::INT) {
+        integers[index] = value.integer;
+        return;
+    }
+
+    unpack();
+    elements[index] = value;
 }
 
-std::string Function::str() {
-    return "function " + func->func_name;
+void Array::unpack() {
+    if(packing == Type::EMPTY) {
+        return;
+    }
+
+    size_t count = length();
+    elements.reserve(count);
+
+    for(size_t i = 0; i < count; i++) {
+        elements.push_back(get(i));
+    }
+
+    packing = Type::EMPTY;
+    std::vector<double>().swap(numbers);
+    std::vector<int64_t>().swap(integers);
 }
 
 std::string Array::str() {
-    std::string result = "[";
-    for(int i = 0; i < elements.size(); i++) {
-        MemoryValue* val = elements.at(i);
-        result += val->str();
+    std::string result;
+    write(result);
+    return result;
+}
+
+void Array::write(std::string& out) {
+    size_t count = length();
+    out += "[";
+
+    for(size_t i = 0; i < count; i++) {
+        get(i).write(out);
 
-        if(i != elements.size() - 1) {
-            result += ", ";
+        if(i != count - 1) {
+            out += ", ";
         }
     }
-    result += "]";
+    out += "]";
+}
+
+// Spreads the bits of x over the whole word, so consecutive integers do
+// not fill consecutive slots.
+static uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// A FLOAT holding an integer, as that integer. Keys that are the same
+// number must hash the same whichever type they have.
+static bool integral(double number, int64_t& integer) {
+    if(number >= -9223372036854775808.0 && number < 9223372036854775808.0 && number == std::trunc(number)) {
+        integer = (int64_t) number;
+        return true;
+    }
+    return false;
+}
+
+bool Map::hashable(TaggedValue key) {
+    switch(key.type) {
+        case Type::FLOAT:
+        case Type::INT:
+        case Type::STRING:
+        case Type::BOOLEAN:
+        case Type::NONE:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+uint64_t Map::hash(TaggedValue key) {
+    switch(key.type) {
+        case Type::INT:
+            return mix((uint64_t) key.integer);
+
+        case Type::FLOAT:
+        {
+            int64_t integer;
+
+            if(integral(key.number, integer)) {
+                return mix((uint64_t) integer);
+            }
+
+            uint64_t bits;
+            memcpy(&bits, &key.number, sizeof(bits));
+            return mix(bits);
+        }
+        case Type::STRING:
+            return mix(std::hash<std::string>()(((String*) key.ref)->value));
+
+        case Type::BOOLEAN:
+            return mix(key.boolean ? 0x7f4a7c15 : 0x3c6ef372);
+
+        default:
+            return mix(0x9e3779b9);
+    }
+}
+
+bool Map::same_key(TaggedValue a, TaggedValue b) {
+    if(a.type != b.type) {
+        if(!a.is_number() || !b.is_number()) {
+            return false;
+        }
+
+        TaggedValue number = a.type == Type::FLOAT ? a : b;
+        TaggedValue integer = a.type == Type::INT ? a : b;
+        int64_t value;
+
+        return integral(number.number, value) && value == integer.integer;
+    }
+
+    switch(a.type) {
+        case Type::FLOAT:
+            return a.number == b.number;
+
+        case Type::INT:
+            return a.integer == b.integer;
+
+        case Type::BOOLEAN:
+            return a.boolean == b.boolean;
+
+        case Type::STRING:
+            return ((String*) a.ref)->value == ((String*) b.ref)->value;
+
+        default:
+            return true;
+    }
+}
+
+// The slot of index holding key, or else the slot where it should be
+// inserted: the first tombstone passed, or the free slot that ended the
+// probe. The table always has a free slot, so the probe ends.
+size_t Map::probe(TaggedValue key, uint64_t hash, bool& found) {
+    size_t mask = index.size() - 1;
+    size_t slot = hash & mask;
+    size_t reusable = index.size();
+
+    for(;; slot = (slot + 1) & mask) {
+        int32_t position = index[slot];
+
+        if(position == FREE) {
+            found = false;
+            return reusable < index.size() ? reusable : slot;
+        }
+
+        if(position == TOMBSTONE) {
+            if(reusable == index.size()) {
+                reusable = slot;
+            }
+            continue;
+        }
+
+        Entry& entry = entries[position];
+
+        if(entry.hash == hash && same_key(entry.key, key)) {
+            found = true;
+            return slot;
+        }
+    }
+}
+
+// Drops removed entries and sizes index for needed keys at a load factor
+// of at most 2/3.
+void Map::rebuild(size_t needed) {
+    size_t capacity = 8;
+
+    while(capacity * 2 < needed * 3) {
+        capacity *= 2;
+    }
+
+    size_t live = 0;
+
+    for(Entry& entry : entries) {
+        if(!entry.key.is_empty()) {
+            entries[live++] = entry;
+        }
+    }
+    entries.resize(live);
+
+    size_t mask = capacity - 1;
+    index.assign(capacity, FREE);
+
+    for(size_t position = 0; position < live; position++) {
+        size_t slot = entries[position].hash & mask;
+
+        while(index[slot] != FREE) {
+            slot = (slot + 1) & mask;
+        }
+        index[slot] = position;
+    }
+}
+
+TaggedValue* Map::find(TaggedValue key) {
+    if(count == 0) {
+        return NULL;
+    }
+
+    bool found;
+    size_t slot = probe(key, hash(key), found);
+
+    return found ? &entries[index[slot]].value : NULL;
+}
+
+// Every used slot of index, tombstones included, belongs to an entry, so
+// keeping entries under 2/3 of index keeps a free slot for probe.
+void Map::insert(TaggedValue key, TaggedValue value) {
+    if((entries.size() + 1) * 3 > index.size() * 2) {
+        rebuild(count + 1);
+    }
+
+    uint64_t key_hash = hash(key);
+    bool found;
+    size_t slot = probe(key, key_hash, found);
+
+    if(found) {
+        entries[index[slot]].value = value;
+        return;
+    }
+
+    index[slot] = entries.size();
+    entries.push_back({ key_hash, key, value });
+    count++;
+}
+
+bool Map::remove(TaggedValue key) {
+    if(count == 0) {
+        return false;
+    }
+
+    bool found;
+    size_t slot = probe(key, hash(key), found);
+
+    if(!found) {
+        return false;
+    }
+
+    Entry& entry = entries[index[slot]];
+    entry.key = TaggedValue();
+    entry.value = TaggedValue();
+
+    index[slot] = TOMBSTONE;
+    count--;
+    return true;
+}
+
+std::string Map::str() {
+    std::string result;
+    write(result);
     return result;
 }
 
+void Map::write(std::string& out) {
+    bool first = true;
+    out += "{";
+
+    for(Entry& entry : entries) {
+        if(entry.key.is_empty()) {
+            continue;
+        }
+
+        out += first ? "" : ", ";
+        entry.key.write(out);
+        out += " = ";
+        entry.value.write(out);
+        first = false;
+    }
+    out += "}";
+}
+
 std::string Object::str() {
+    if(!class_name.empty()) {
+        return class_name + " object";
+    }
     return "object";
-}
\ No newline at end of file
+}
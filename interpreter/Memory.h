@@ -5,19 +5,101 @@
 #include <map>
 #include <iostream>
 #include <vector>
+#include <cstdint>
 #include "../parser/AST.h"
+#include "Symbol.h"
+#include "Heap.h"
 
 enum class Type {
     FLOAT,
+    INT,
     STRING,
     BOOLEAN,
     ARRAY,
+    MAP,
     FUNCTION,
+    NATIVE,
     OBJECT,
-    NONE
+    HANDLE,
+    NONE,
+    EMPTY
 };
 
-class MemoryValue {
+class MemoryValue;
+class Chunk;
+
+// Unboxed value passed around by the interpreter. Numbers, booleans and None
+// are stored inline, everything else is a pointer to a heap MemoryValue.
+// EMPTY marks the absence of a value (what a statement evaluates to).
+class TaggedValue {
+    public:
+        Type type;
+
+        union {
+            double number;
+            int64_t integer;
+            bool boolean;
+            MemoryValue* ref;
+        };
+
+        TaggedValue() {
+            this->type = Type::EMPTY;
+            this->ref = NULL;
+        }
+
+        TaggedValue(double number) {
+            this->type = Type::FLOAT;
+            this->number = number;
+        }
+
+        TaggedValue(int64_t integer) {
+            this->type = Type::INT;
+            this->integer = integer;
+        }
+
+        TaggedValue(bool boolean) {
+            this->type = Type::BOOLEAN;
+            this->boolean = boolean;
+        }
+
+        TaggedValue(MemoryValue* ref);
+
+        static TaggedValue none() {
+            TaggedValue value;
+            value.type = Type::NONE;
+            return value;
+        }
+
+        bool is_empty() {
+            return type == Type::EMPTY;
+        }
+
+        bool is_true() {
+            return type == Type::BOOLEAN && boolean;
+        }
+
+        bool is_number() {
+            return type == Type::INT || type == Type::FLOAT;
+        }
+
+        // The value of an INT or FLOAT as a double, for mixed arithmetic.
+        double as_double() {
+            return type == Type::INT ? (double) integer : number;
+        }
+
+        bool is_heap() {
+            return type == Type::STRING || type == Type::ARRAY || type == Type::MAP ||
+                   type == Type::FUNCTION || type == Type::NATIVE || type == Type::OBJECT ||
+                   type == Type::HANDLE;
+        }
+
+        std::string str();
+
+        // Appends str() to out without building intermediate strings.
+        void write(std::string& out);
+};
+
+class MemoryValue : public HeapObject {
     public:
         Type type;
 
@@ -26,82 +108,324 @@ class MemoryValue {
         }
 
         virtual ~MemoryValue() = 0;
-        
+
         virtual std::string str() = 0;
+
+        virtual void write(std::string& out) {
+            out += str();
+        }
 };
 
-class SingularMemoryValue : public MemoryValue {
+class String : public MemoryValue {
     public:
         std::string value;
 
         std::string str() override;
+        void write(std::string& out) override;
 
-        SingularMemoryValue(std::string value, Type type)
-        : MemoryValue(type) {
+        String(std::string value)
+        : MemoryValue(Type::STRING) {
             this->value = value;
         }
 
-        ~SingularMemoryValue() override {}
+        void trace(Heap*) override {}
+
+        size_t size() override {
+            return sizeof(String) + value.capacity();
+        }
+
+        ~String() override {}
 };
 
+// While every element is a FLOAT, or every element an INT, the array is
+// packed: the raw numbers are stored contiguously in numbers or integers
+// and elements is unused. Storing a value of any other type unpacks it
+// into boxed elements for good.
 class Array : public MemoryValue {
     public:
-        std::vector<MemoryValue*> elements;
+        // FLOAT or INT while packed, EMPTY once boxed.
+        Type packing;
+
+        std::vector<TaggedValue> elements;
+        std::vector<double> numbers;
+        std::vector<int64_t> integers;
+
+        Array(std::vector<TaggedValue> elements);
 
-        Array(std::vector<MemoryValue*> elements)
+        Array()
         : MemoryValue(Type::ARRAY) {
-            this->elements = elements;
+            this->packing = Type::EMPTY;
         }
 
-        Array()
-        : MemoryValue(Type::ARRAY) {}
+        // length zeros, packed as FLOAT or INT.
+        Array(Type packing, size_t length)
+        : MemoryValue(Type::ARRAY) {
+            this->packing = packing;
+
+            if(packing == Type::FLOAT) {
+                numbers.resize(length);
+            } else {
+                integers.resize(length);
+            }
+        }
+
+        size_t length() {
+            switch(packing) {
+                case Type::FLOAT:
+                    return numbers.size();
+
+                case Type::INT:
+                    return integers.size();
+
+                default:
+                    return elements.size();
+            }
+        }
+
+        TaggedValue get(size_t index) {
+            switch(packing) {
+                case Type::FLOAT:
+                    return TaggedValue(numbers[index]);
+
+                case Type::INT:
+                    return TaggedValue(integers[index]);
+
+                default:
+                    return elements[index];
+            }
+        }
+
+        void set(size_t index, TaggedValue value);
+        void unpack();
 
         std::string str() override;
+        void write(std::string& out) override;
+
+        void trace(Heap* heap) override {
+            for(TaggedValue& element : elements) {
+                heap->mark(element);
+            }
+        }
+
+        size_t size() override {
+            return sizeof(Array) + elements.capacity() * sizeof(TaggedValue) +
+                   numbers.capacity() * sizeof(double) + integers.capacity() * sizeof(int64_t);
+        }
 
         ~Array() override {}
 };
 
+// Hash map that keeps its keys in insertion order. entries holds the pairs
+// as they were first inserted, each with its key's hash, and index is an
+// open addressing table (linear probing, power-of-two size) of positions in
+// entries. Probes compare the cached hashes before the keys, and growing
+// the table never rehashes a string. Removing a key leaves an EMPTY key in
+// entries and a tombstone in index until the next rebuild.
+//
+// Keys are numbers, strings, booleans or None, and compare like ==, except
+// that an INT only equals a FLOAT holding exactly the same integer.
+class Map : public MemoryValue {
+    public:
+        struct Entry {
+            uint64_t hash;
+            TaggedValue key;
+            TaggedValue value;
+        };
+
+        std::vector<Entry> entries;
+        std::vector<int32_t> index;
+        size_t count;
+
+        Map()
+        : MemoryValue(Type::MAP) {
+            this->count = 0;
+        }
+
+        static bool hashable(TaggedValue key);
+
+        // The value stored under key, or NULL if there is none.
+        TaggedValue* find(TaggedValue key);
+
+        void insert(TaggedValue key, TaggedValue value);
+        bool remove(TaggedValue key);
+
+        std::string str() override;
+        void write(std::string& out) override;
+
+        void trace(Heap* heap) override {
+            for(Entry& entry : entries) {
+                heap->mark(entry.key);
+                heap->mark(entry.value);
+            }
+        }
+
+        size_t size() override {
+            return sizeof(Map) + entries.capacity() * sizeof(Entry) + index.capacity() * sizeof(int32_t);
+        }
+
+        ~Map() override {}
+
+    private:
+        static constexpr int32_t FREE = -1;
+        static constexpr int32_t TOMBSTONE = -2;
+
+        static uint64_t hash(TaggedValue key);
+        static bool same_key(TaggedValue a, TaggedValue b);
+
+        size_t probe(TaggedValue key, uint64_t hash, bool& found);
+        void rebuild(size_t needed);
+};
+
+class Memory;
+
 class Function : public MemoryValue {
     public:
         FunctionInit* func;
+        Chunk* chunk;
+        Memory* closure;
 
-        Function(FunctionInit* func)
+        Function(FunctionInit* func, Chunk* chunk, Memory* closure)
         : MemoryValue(Type::FUNCTION) {
             this->func = func;
+            this->chunk = chunk;
+            this->closure = closure;
         }
 
         std::string str() override;
 
+        void trace(Heap* heap) override;
+
+        size_t size() override {
+            return sizeof(Function);
+        }
+
         ~Function() override {}
 };
 
-class Memory {
+// Runtime storage for one lexical scope. Variables are addressed by the
+// slot the SemanticAnalyzer assigned them; layout is only consulted for
+// lookups by name, such as object:member.
+class Memory : public HeapObject {
     public:
-        std::map<std::string, MemoryValue*> values;
+        SymbolTable* layout;
+        std::vector<TaggedValue> slots;
         Memory* enclosing_memory_block;
-        int memory_level;
 
-        Memory(int memory_level, Memory* enclosing_memory_block);
+        Memory(SymbolTable* layout, Memory* enclosing_memory_block);
+
+        void reset(SymbolTable* layout, Memory* enclosing_memory_block) {
+            this->layout = layout;
+            this->slots.assign(layout->size(), TaggedValue());
+            this->enclosing_memory_block = enclosing_memory_block;
+        }
 
         std::string str();
 
-        void put(std::string name, MemoryValue* val);
+        Memory* up(int depth) {
+            Memory* memory = this;
+
+            while(depth-- > 0) {
+                memory = memory->enclosing_memory_block;
+            }
+            return memory;
+        }
+
+        void trace(Heap* heap) override {
+            for(TaggedValue& value : slots) {
+                heap->mark(value);
+            }
+            heap->mark(enclosing_memory_block);
+        }
+
+        size_t size() override {
+            return sizeof(Memory) + slots.capacity() * sizeof(TaggedValue);
+        }
+};
+
+// A function implemented in C++, such as the members of a built-in
+// library. args points at the argc arguments on the caller's stack, which
+// stay rooted while the function runs.
+typedef TaggedValue (*NativeCode)(TaggedValue* args, int argc, Token* token);
+
+class NativeFunction : public MemoryValue {
+    public:
+        std::string name;
+        NativeCode code;
+
+        // Number of arguments, or -1 when the function checks them itself.
+        int arity;
+
+        NativeFunction(std::string name, int arity, NativeCode code)
+        : MemoryValue(Type::NATIVE) {
+            this->name = name;
+            this->arity = arity;
+            this->code = code;
+        }
+
+        bool accepts(int argc) {
+            return arity < 0 || arity == argc;
+        }
 
-        MemoryValue* get(std::string name, bool only_this_block);
+        std::string str() override;
+
+        void trace(Heap*) override {}
+
+        size_t size() override {
+            return sizeof(NativeFunction) + name.capacity();
+        }
+
+        ~NativeFunction() override {}
 };
 
+// A module, or an instance of a class, which has its class's name.
 class Object : public MemoryValue {
     public:
         Memory* object_memory;
+        std::string class_name;
 
         Object(Memory* memory)
         : MemoryValue(Type::OBJECT) {
             this->object_memory = memory;
         }
 
+        Object(Memory* memory, std::string class_name)
+        : MemoryValue(Type::OBJECT) {
+            this->object_memory = memory;
+            this->class_name = class_name;
+        }
+
         std::string str() override;
 
+        void trace(Heap* heap) override {
+            heap->mark(object_memory);
+        }
+
+        size_t size() override {
+            return sizeof(Object) + class_name.capacity();
+        }
+
         ~Object() override {}
 };
 
-#endif
\ No newline at end of file
+// A resource owned by a built-in library, such as an open file, released
+// when the collector frees the handle. One that a for loop can walk
+// through overrides iterable and next.
+class Handle : public MemoryValue {
+    public:
+        Handle()
+        : MemoryValue(Type::HANDLE) {}
+
+        virtual bool iterable() {
+            return false;
+        }
+
+        // Stores the next element in its argument, or returns false at the
+        // end.
+        virtual bool next(TaggedValue&) {
+            return false;
+        }
+
+        void trace(Heap*) override {}
+};
+
+#endif
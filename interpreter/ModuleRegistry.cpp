@@ -0,0 +1,167 @@
+#include "ModuleRegistry.h"
+#include <algorithm>
+#include <filesystem>
+
+ModuleRegistry module_registry;
+
+ModuleRegistry::ModuleRegistry() {
+    registered = false;
+}
+
+TaggedValue ModuleRegistry::find(std::string path, Token* token) {
+    std::map<std::string, TaggedValue>::iterator it = modules.find(path);
+
+    if(it != modules.end()) {
+        return it->second;
+    }
+
+    std::vector<std::string>::iterator cycle = std::find(loading.begin(), loading.end(), path);
+
+    if(cycle != loading.end()) {
+        std::string message = "Circular import: ";
+
+        for(; cycle != loading.end(); cycle++) {
+            message += *cycle + " -> ";
+        }
+        message += path + ".";
+
+        ImportError(token->file, token->line, token->column, message).cast();
+    }
+
+    if(!std::filesystem::is_regular_file(path)) {
+        std::string message = "Module " + token->value + " not found.";
+        ImportError(token->file, token->line, token->column, message).cast();
+    }
+
+    return TaggedValue();
+}
+
+AST* ModuleRegistry::parse_file(std::string path, std::vector<Import*>& imports) {
+    Lexer* lexer = new Lexer(path);
+    Parser* parser = new Parser(lexer);
+
+    AST* tree = parser->parse();
+    SemanticAnalyzer().visit(tree);
+    tree = Optimizer().visit(tree);
+
+    imports = parser->imports;
+    return tree;
+}
+
+AST* ModuleRegistry::parse(std::string path) {
+    std::map<std::string, AST*>::iterator it = trees.find(get_canonical_path(path));
+
+    if(it != trees.end()) {
+        return it->second;
+    }
+
+    std::vector<Import*> imports;
+    return parse_file(path, imports);
+}
+
+void ModuleRegistry::preload(std::string path, int threads) {
+    std::string canonical_path = get_canonical_path(path);
+    std::vector<Import*> imports;
+
+    trees[canonical_path] = parse_file(path, imports);
+    scheduled.insert(canonical_path);
+
+    if(imports.empty()) {
+        return;
+    }
+
+    ThreadPool pool(threads);
+    preload_imports(pool, path, imports);
+    pool.wait();
+}
+
+void ModuleRegistry::preload_imports(ThreadPool& pool, std::string importer, std::vector<Import*>& imports) {
+    for(Import* import : imports) {
+        if(import->token->type_of(TokenType::BUILT_IN_LIB)) {
+            continue;
+        }
+
+        std::string path = get_dir_from_path(importer) + import->path;
+        std::string canonical_path = get_canonical_path(path);
+
+        if(!std::filesystem::is_regular_file(canonical_path)) {
+            continue;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            if(!scheduled.insert(canonical_path).second) {
+                continue;
+            }
+        }
+
+        pool.submit([this, &pool, path, canonical_path] {
+            preload_module(pool, path, canonical_path);
+        });
+    }
+}
+
+void ModuleRegistry::preload_module(ThreadPool& pool, std::string path, std::string canonical_path) {
+    std::vector<Import*> imports;
+    AST* tree;
+
+    // A module with errors is left out of the cache. It is parsed again
+    // when execution reaches its import, which reports the error there.
+    Error::deferred = true;
+
+    try {
+        tree = parse_file(path, imports);
+    } catch(Error& error) {
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        trees[canonical_path] = tree;
+    }
+
+    preload_imports(pool, path, imports);
+}
+
+// Registered lazily: the heap is a global in another translation unit and
+// may not be constructed yet when this one is.
+void ModuleRegistry::register_roots() {
+    if(!registered) {
+        heap.add_roots(this);
+        registered = true;
+    }
+}
+
+void ModuleRegistry::begin(std::string path) {
+    register_roots();
+    loading.push_back(path);
+}
+
+TaggedValue ModuleRegistry::builtin(Token* name) {
+    std::string key = "$" + name->value;
+    std::map<std::string, TaggedValue>::iterator it = modules.find(key);
+
+    if(it != modules.end()) {
+        return it->second;
+    }
+
+    register_roots();
+
+    TaggedValue library = Builtins::load(name);
+    modules[key] = library;
+    return library;
+}
+
+void ModuleRegistry::finish(std::string path, TaggedValue module) {
+    loading.pop_back();
+    modules[path] = module;
+}
+
+void ModuleRegistry::trace_roots(Heap* heap) {
+    std::map<std::string, TaggedValue>::iterator it;
+
+    for(it = modules.begin(); it != modules.end(); it++) {
+        heap->mark(it->second);
+    }
+}
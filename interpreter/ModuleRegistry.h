@@ -0,0 +1,70 @@
+#ifndef MODULE_REGISTRY_H
+#define MODULE_REGISTRY_H
+
+#include <string>
+#include <map>
+#include <vector>
+#include <set>
+#include <mutex>
+#include "Memory.h"
+#include "Heap.h"
+#include "SemanticAnalyzer.h"
+#include "Optimizer.h"
+#include "../lexer/Lexer.h"
+#include "../parser/Parser.h"
+#include "../utils/Error.h"
+#include "../utils/ThreadPool.h"
+#include "../utils/Path.h"
+#include "../lib/Builtins.h"
+
+// Process-wide cache of evaluated modules, keyed by canonical path. Each
+// file is lexed, parsed, analyzed and run once; every later import gets
+// the same Object. A module that is imported again while it is still being
+// evaluated is an import cycle.
+//
+// preload() walks the import graph before execution and prepares the tree
+// of every reachable module on a thread pool. Modules are still evaluated
+// lazily, in the same order as before, when execution reaches their import.
+class ModuleRegistry : public RootSet {
+    public:
+        ModuleRegistry();
+
+        void preload(std::string path, int threads);
+
+        // The analyzed tree of the module at path, prepared by preload()
+        // or parsed now if it was not reached.
+        AST* parse(std::string path);
+
+        // The cached module at path, or an empty value if it still has to
+        // be evaluated. Raises an ImportError on a cycle or a missing file.
+        TaggedValue find(std::string path, Token* token);
+
+        // The built-in library $name, built on its first import.
+        TaggedValue builtin(Token* name);
+
+        void begin(std::string path);
+        void finish(std::string path, TaggedValue module);
+
+        void trace_roots(Heap* heap) override;
+
+    private:
+        std::map<std::string, TaggedValue> modules;
+        std::vector<std::string> loading;
+
+        bool registered;
+
+        std::map<std::string, AST*> trees;
+        std::set<std::string> scheduled;
+        std::mutex mutex;
+
+        void register_roots();
+
+        AST* parse_file(std::string path, std::vector<Import*>& imports);
+
+        void preload_imports(ThreadPool& pool, std::string importer, std::vector<Import*>& imports);
+        void preload_module(ThreadPool& pool, std::string path, std::string canonical_path);
+};
+
+extern ModuleRegistry module_registry;
+
+#endif
@@ -0,0 +1,665 @@
+#include "Operations.h"
+#include "ArrayKernels.h"
+#include <cmath>
+#include <charconv>
+
+void Operations::type_mismatch_error(Token* token) {
+    std::string message = "Type mismatch.";
+    std::string file_path = token->file;
+    SyntaxError(file_path, token->line, token->column, message).cast();
+}
+
+void Operations::value_error(Token* token) {
+    std::string message = "Value cannot be converted to " + token->value + ".";
+    std::string file_path = token->file;
+    ValueError(file_path, token->line, token->column, message).cast();
+}
+
+static void division_by_zero(Token* token) {
+    std::string message = "Division by zero.";
+    ValueError(token->file, token->line, token->column, message).cast();
+}
+
+void Operations::index_error(Token* token) {
+    std::string message = "Index out of bounds.";
+    std::string file_path = token->file;
+    SyntaxError(file_path, token->line, token->column, message).cast();
+}
+
+// Arithmetic on two INTs. Returns false when the result does not fit in
+// an int64, so the caller redoes it in floating point.
+static bool int_op(TokenType op, int64_t x, int64_t y, TaggedValue& result, Token* right_token) {
+    int64_t value;
+
+    switch(op) {
+        case TokenType::PLUS:
+            if(__builtin_add_overflow(x, y, &value)) {
+                return false;
+            }
+            break;
+
+        case TokenType::MINUS:
+            if(__builtin_sub_overflow(x, y, &value)) {
+                return false;
+            }
+            break;
+
+        case TokenType::MULT:
+            if(__builtin_mul_overflow(x, y, &value)) {
+                return false;
+            }
+            break;
+
+        case TokenType::DIV:
+            result = TaggedValue((double) x / (double) y);
+            return true;
+
+        case TokenType::INT_DIV:
+        case TokenType::MODULO:
+            if(y == 0) {
+                division_by_zero(right_token);
+            }
+
+            // INT64_MIN // -1 overflows, and x % -1 traps on some CPUs.
+            if(y == -1) {
+                if(op == TokenType::MODULO) {
+                    value = 0;
+                } else if(x == INT64_MIN) {
+                    return false;
+                } else {
+                    value = -x;
+                }
+                break;
+            }
+
+            value = op == TokenType::INT_DIV ? x / y : x % y;
+            break;
+
+        default:
+            return false;
+    }
+
+    result = TaggedValue(value);
+    return true;
+}
+
+// The numeric type every element of an operand shares: an array's packing,
+// or a number's own type. EMPTY when there is none.
+static Type element_type(TaggedValue value) {
+    if(value.type == Type::ARRAY) {
+        return ((Array*) value.ref)->packing;
+    }
+    return value.is_number() ? value.type : Type::EMPTY;
+}
+
+// Packed storage of an operand as doubles; ints are converted into spare.
+static const double* doubles_of(TaggedValue value, std::vector<double>& spare) {
+    if(value.type != Type::ARRAY) {
+        spare.assign(1, value.as_double());
+        return spare.data();
+    }
+
+    Array* array = (Array*) value.ref;
+
+    if(array->packing == Type::FLOAT) {
+        return array->numbers.data();
+    }
+
+    spare.assign(array->integers.begin(), array->integers.end());
+    return spare.data();
+}
+
+static const int64_t* integers_of(TaggedValue& value) {
+    if(value.type != Type::ARRAY) {
+        return &value.integer;
+    }
+    return ((Array*) value.ref)->integers.data();
+}
+
+// Arithmetic where at least one operand is an array: the other is an array
+// of the same length, or a value combined with every element. Packed
+// operands go through the SIMD kernels; anything else, and any int result
+// that overflows, is computed element by element.
+static TaggedValue array_op(TokenType op, TaggedValue left, TaggedValue right, Token* left_token, Token* right_token) {
+    bool left_scalar = left.type != Type::ARRAY;
+    bool right_scalar = right.type != Type::ARRAY;
+
+    size_t n = left_scalar ? ((Array*) right.ref)->length() : ((Array*) left.ref)->length();
+
+    if(!left_scalar && !right_scalar && ((Array*) right.ref)->length() != n) {
+        std::string message = "Arrays have different lengths.";
+        ValueError(right_token->file, right_token->line, right_token->column, message).cast();
+    }
+
+    Type left_type = element_type(left);
+    Type right_type = element_type(right);
+
+    bool arithmetic = op == TokenType::PLUS || op == TokenType::MINUS ||
+                      op == TokenType::MULT || op == TokenType::DIV;
+
+    if(arithmetic && left_type != Type::EMPTY && right_type != Type::EMPTY) {
+        bool ints = left_type == Type::INT && right_type == Type::INT;
+
+        if(ints && (op == TokenType::PLUS || op == TokenType::MINUS)) {
+            Array* result = new Array(Type::INT, n);
+
+            if(ArrayKernels::apply(op, integers_of(left), left_scalar, integers_of(right), right_scalar,
+                                   result->integers.data(), n)) {
+                return TaggedValue(heap.track(result));
+            }
+            delete result;
+
+        } else if(!ints || op == TokenType::DIV) {
+            std::vector<double> left_spare, right_spare;
+            Array* result = new Array(Type::FLOAT, n);
+
+            ArrayKernels::apply(op, doubles_of(left, left_spare), left_scalar, doubles_of(right, right_spare), right_scalar,
+                                result->numbers.data(), n);
+            return TaggedValue(heap.track(result));
+        }
+    }
+
+    std::vector<TaggedValue> results;
+    results.reserve(n);
+
+    for(size_t i = 0; i < n; i++) {
+        TaggedValue x = left_scalar ? left : ((Array*) left.ref)->get(i);
+        TaggedValue y = right_scalar ? right : ((Array*) right.ref)->get(i);
+
+        results.push_back(Operations::binary_op(op, x, y, left_token, right_token));
+    }
+
+    return TaggedValue(heap.track(new Array(results)));
+}
+
+TaggedValue Operations::binary_op(TokenType op, TaggedValue left, TaggedValue right, Token* left_token, Token* right_token) {
+    if(left.type == Type::ARRAY || right.type == Type::ARRAY) {
+        return array_op(op, left, right, left_token, right_token);
+    }
+
+    if(op == TokenType::PLUS && left.type == Type::STRING) {
+        if(right.type != Type::STRING) {
+            type_mismatch_error(right_token);
+        }
+
+        std::string& a = ((String*) left.ref)->value;
+        std::string& b = ((String*) right.ref)->value;
+
+        return TaggedValue(heap.track(new String(a + b)));
+    }
+
+    if(!left.is_number()) {
+        type_mismatch_error(op == TokenType::PLUS ? left_token : right_token);
+    }
+
+    if(!right.is_number()) {
+        type_mismatch_error(right_token);
+    }
+
+    if(left.type == Type::INT && right.type == Type::INT) {
+        TaggedValue result;
+
+        if(int_op(op, left.integer, right.integer, result, right_token)) {
+            return result;
+        }
+    }
+
+    double x = left.as_double();
+    double y = right.as_double();
+
+    switch(op) {
+        case TokenType::PLUS:
+            return TaggedValue(x + y);
+
+        case TokenType::MINUS:
+            return TaggedValue(x - y);
+
+        case TokenType::MULT:
+            return TaggedValue(x * y);
+
+        case TokenType::DIV:
+            return TaggedValue(x / y);
+
+        case TokenType::INT_DIV:
+            if(y == 0) {
+                division_by_zero(right_token);
+            }
+            return TaggedValue(std::trunc(x / y));
+
+        case TokenType::MODULO:
+            return TaggedValue(fmod(x, y));
+
+        default:
+            type_mismatch_error(left_token);
+    }
+    return TaggedValue();
+}
+
+TaggedValue Operations::unary_minus(TaggedValue value, Token* token) {
+    if(value.type == Type::INT && value.integer != INT64_MIN) {
+        return TaggedValue(-value.integer);
+    }
+
+    if(!value.is_number()) {
+        type_mismatch_error(token);
+    }
+    return TaggedValue(-value.as_double());
+}
+
+TaggedValue Operations::negate(TaggedValue value, Token* token) {
+    if(value.type != Type::BOOLEAN) {
+        type_mismatch_error(token);
+    }
+    return TaggedValue(!value.boolean);
+}
+
+bool Operations::values_equal(TaggedValue left, TaggedValue right) {
+    if(left.type != right.type) {
+        return left.is_number() && right.is_number() && left.as_double() == right.as_double();
+    }
+
+    switch(left.type) {
+        case Type::FLOAT:
+            return left.number == right.number;
+
+        case Type::INT:
+            return left.integer == right.integer;
+
+        case Type::BOOLEAN:
+            return left.boolean == right.boolean;
+
+        case Type::NONE:
+            return true;
+
+        case Type::STRING:
+            return ((String*) left.ref)->value == ((String*) right.ref)->value;
+
+        default:
+            return left.ref == right.ref;
+    }
+}
+
+bool Operations::compare(TokenType op, TaggedValue left, TaggedValue right, Token* token) {
+    switch(op) {
+        case TokenType::EQUALS:
+            return values_equal(left, right);
+
+        case TokenType::NOT_EQUALS:
+            return !values_equal(left, right);
+
+        default:
+            break;
+    }
+
+    if(left.type == Type::INT && right.type == Type::INT) {
+        int64_t a = left.integer;
+        int64_t b = right.integer;
+
+        switch(op) {
+            case TokenType::MORE_OR_EQ:
+                return a >= b;
+
+            case TokenType::LESS_OR_EQ:
+                return a <= b;
+
+            case TokenType::LESS:
+                return a < b;
+
+            case TokenType::MORE:
+                return a > b;
+
+            default:
+                return false;
+        }
+    }
+
+    if(!left.is_number() || !right.is_number()) {
+        type_mismatch_error(token);
+    }
+
+    double x = left.as_double();
+    double y = right.as_double();
+
+    switch(op) {
+        case TokenType::MORE_OR_EQ:
+            return x >= y;
+
+        case TokenType::LESS_OR_EQ:
+            return x <= y;
+
+        case TokenType::LESS:
+            return x < y;
+
+        case TokenType::MORE:
+            return x > y;
+
+        default:
+            return false;
+    }
+}
+
+static bool is_number_literal(std::string& value) {
+    int dots = 0;
+
+    for(char c : value) {
+        if(!isdigit(c) && c != '.') {
+            return false;
+        }
+
+        if(c == '.') {
+            dots++;
+
+            if(dots > 1) {
+                return false;
+            }
+        }
+    }
+    return !value.empty();
+}
+
+// `as int` of a float rounds toward zero; values outside int64 cannot
+// be converted.
+static TaggedValue truncate(double number, Token* type) {
+    if(!(number > -9223372036854775808.0 && number < 9223372036854775808.0)) {
+        Operations::value_error(type);
+    }
+    return TaggedValue((int64_t) number);
+}
+
+TaggedValue Operations::cast(TaggedValue value, Token* type) {
+    TokenType target = type->type;
+
+    switch(value.type) {
+        case Type::FLOAT:
+        {
+            switch(target) {
+                case TokenType::CAST_FLOAT:
+                    return value;
+
+                case TokenType::CAST_INT:
+                    return truncate(value.number, type);
+
+                case TokenType::CAST_STRING:
+                    return TaggedValue(heap.track(new String(value.str())));
+
+                default:
+                    break;
+            }
+            break;
+        }
+        case Type::INT:
+        {
+            switch(target) {
+                case TokenType::CAST_INT:
+                    return value;
+
+                case TokenType::CAST_FLOAT:
+                    return TaggedValue((double) value.integer);
+
+                case TokenType::CAST_STRING:
+                    return TaggedValue(heap.track(new String(value.str())));
+
+                default:
+                    break;
+            }
+            break;
+        }
+        case Type::BOOLEAN:
+        case Type::NONE:
+        {
+            if(target == TokenType::CAST_STRING) {
+                return TaggedValue(heap.track(new String(value.str())));
+            }
+
+            if(target == TokenType::CAST_BOOL && value.type == Type::BOOLEAN) {
+                return value;
+            }
+            break;
+        }
+        case Type::STRING:
+        {
+            std::string& str = ((String*) value.ref)->value;
+
+            switch(target) {
+                case TokenType::CAST_FLOAT:
+                case TokenType::CAST_INT:
+                {
+                    if(!is_number_literal(str)) {
+                        value_error(type);
+                    }
+
+                    if(target == TokenType::CAST_FLOAT) {
+                        return TaggedValue(std::stod(str));
+                    }
+
+                    int64_t integer;
+                    std::from_chars_result parsed = std::from_chars(str.data(), str.data() + str.size(), integer);
+
+                    if(parsed.ec == std::errc() && parsed.ptr == str.data() + str.size()) {
+                        return TaggedValue(integer);
+                    }
+                    return truncate(std::stod(str), type);
+                }
+                case TokenType::CAST_STRING:
+                    return value;
+
+                case TokenType::CAST_BOOL:
+                {
+                    if(str == Values::TRUE || str == Values::FALSE) {
+                        return TaggedValue(str == Values::TRUE);
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+            break;
+        }
+        case Type::ARRAY:
+        {
+            Array* array = (Array*) value.ref;
+
+            switch(target) {
+                case TokenType::CAST_STRING:
+                    return TaggedValue(heap.track(new String(array->str())));
+
+                case TokenType::CAST_INT:
+                    return TaggedValue((int64_t) array->length());
+
+                case TokenType::CAST_FLOAT:
+                    return TaggedValue((double) array->length());
+
+                case TokenType::CAST_BOOL:
+                    return TaggedValue(array->length() > 0);
+
+                default:
+                    break;
+            }
+            break;
+        }
+        case Type::MAP:
+        {
+            Map* map = (Map*) value.ref;
+
+            switch(target) {
+                case TokenType::CAST_STRING:
+                    return TaggedValue(heap.track(new String(map->str())));
+
+                case TokenType::CAST_INT:
+                    return TaggedValue((int64_t) map->count);
+
+                case TokenType::CAST_FLOAT:
+                    return TaggedValue((double) map->count);
+
+                case TokenType::CAST_BOOL:
+                    return TaggedValue(map->count > 0);
+
+                default:
+                    break;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    value_error(type);
+    return TaggedValue();
+}
+
+static Array* checked_array(TaggedValue array, Token* array_token) {
+    if(array.type != Type::ARRAY) {
+        std::string message = "Given object is not an array.";
+        std::string file_path = array_token->file;
+        SyntaxError(file_path, array_token->line, array_token->column, message).cast();
+    }
+    return (Array*) array.ref;
+}
+
+static int64_t checked_index(TaggedValue index, size_t size, Token* index_token) {
+    int64_t i;
+
+    if(index.type == Type::INT) {
+        i = index.integer;
+    } else if(index.type == Type::FLOAT) {
+        if(!std::isfinite(index.number) || index.number < 0 || index.number >= (double) size) {
+            Operations::index_error(index_token);
+        }
+        i = (int64_t) index.number;
+    } else {
+        Operations::type_mismatch_error(index_token);
+    }
+
+    if(i < 0 || i >= (int64_t) size) {
+        Operations::index_error(index_token);
+    }
+    return i;
+}
+
+TaggedValue Operations::array_get(TaggedValue array, TaggedValue index, Token* array_token, Token* index_token) {
+    if(array.type == Type::MAP) {
+        TaggedValue* value = ((Map*) array.ref)->find(index);
+        return value != NULL ? *value : TaggedValue::none();
+    }
+
+    Array* elements = checked_array(array, array_token);
+    return elements->get(checked_index(index, elements->length(), index_token));
+}
+
+void Operations::array_set(TaggedValue array, TaggedValue index, TaggedValue value, Token* array_token, Token* index_token) {
+    if(array.type == Type::MAP) {
+        map_insert((Map*) array.ref, index, value, index_token);
+        return;
+    }
+
+    Array* elements = checked_array(array, array_token);
+    elements->set(checked_index(index, elements->length(), index_token), value);
+
+    if(value.is_heap()) {
+        heap.write_barrier(elements);
+    }
+}
+
+void Operations::member_set(TaggedValue object, MemberCache* cache, TaggedValue value, Token* token) {
+    if(object.type != Type::OBJECT) {
+        std::string message = "Variable is not object type.";
+        ValueError(token->file, token->line, token->column, message).cast();
+    }
+
+    Memory* memory = ((Object*) object.ref)->object_memory;
+    int slot = cache->lookup(memory->layout);
+
+    if(slot == -1) {
+        std::string message = "Object has no member " + cache->name + ".";
+        NameError(token->file, token->line, token->column, message).cast();
+    }
+
+    memory->slots[slot] = value;
+    heap.write_barrier(memory);
+}
+
+void Operations::map_insert(Map* map, TaggedValue key, TaggedValue value, Token* key_token) {
+    if(!Map::hashable(key)) {
+        std::string message = "Map keys must be numbers, strings, booleans or None.";
+        ValueError(key_token->file, key_token->line, key_token->column, message).cast();
+    }
+
+    map->insert(key, value);
+
+    if(key.is_heap() || value.is_heap()) {
+        heap.write_barrier(map);
+    }
+}
+
+static Map* checked_map(TaggedValue map, Token* map_token) {
+    if(map.type != Type::MAP) {
+        std::string message = "Given object is not a map.";
+        SyntaxError(map_token->file, map_token->line, map_token->column, message).cast();
+    }
+    return (Map*) map.ref;
+}
+
+// Deleting a missing key is an error, unlike reading one.
+void Operations::map_delete(TaggedValue map, TaggedValue key, Token* map_token, Token* key_token) {
+    if(!checked_map(map, map_token)->remove(key)) {
+        std::string message = "Key " + key.str() + " not found.";
+        ValueError(key_token->file, key_token->line, key_token->column, message).cast();
+    }
+}
+
+TaggedValue Operations::map_member(TaggedValue map, std::string name, Token* token) {
+    Map* entries = checked_map(map, token);
+
+    if(name != "keys" && name != "values") {
+        std::string message = "Maps only have keys and values.";
+        NameError(token->file, token->line, token->column, message).cast();
+    }
+
+    std::vector<TaggedValue> elements;
+    elements.reserve(entries->count);
+
+    for(Map::Entry& entry : entries->entries) {
+        if(!entry.key.is_empty()) {
+            elements.push_back(name == "keys" ? entry.key : entry.value);
+        }
+    }
+
+    return TaggedValue(heap.track(new Array(elements)));
+}
+
+void Operations::check_range(TaggedValue start, TaggedValue end, TaggedValue step, Token* token) {
+    if(!start.is_number() || !end.is_number() || !step.is_number()) {
+        std::string message = "Range bounds must be numbers.";
+        ValueError(token->file, token->line, token->column, message).cast();
+    }
+
+    if(step.as_double() == 0) {
+        std::string message = "Range step cannot be zero.";
+        ValueError(token->file, token->line, token->column, message).cast();
+    }
+}
+
+bool Operations::range_continues_slow(TaggedValue var, TaggedValue end, TaggedValue step, Token* token) {
+    if(!var.is_number()) {
+        type_mismatch_error(token);
+    }
+
+    TokenType op = step.as_double() > 0 ? TokenType::LESS : TokenType::MORE;
+    return compare(op, var, end, token);
+}
+
+TaggedValue Operations::iterable(TaggedValue value, Token* token) {
+    if(value.type == Type::MAP) {
+        return map_member(value, "keys", token);
+    }
+
+    if(value.type == Type::HANDLE && ((Handle*) value.ref)->iterable()) {
+        return value;
+    }
+
+    if(value.type != Type::ARRAY) {
+        std::string message = "Given object is not an array or a map.";
+        SyntaxError(token->file, token->line, token->column, message).cast();
+    }
+    return value;
+}
@@ -0,0 +1,69 @@
+#ifndef OPERATIONS_H
+#define OPERATIONS_H
+
+#include "Memory.h"
+#include "../lexer/Token.h"
+#include "../utils/Values.h"
+#include "../utils/Error.h"
+
+// Value semantics shared by the tree-walking Interpreter and the VM, so
+// both execution modes agree on arithmetic, comparisons and casts.
+namespace Operations {
+    void type_mismatch_error(Token* token);
+    void value_error(Token* token);
+    void index_error(Token* token);
+
+    TaggedValue binary_op(TokenType op, TaggedValue left, TaggedValue right, Token* left_token, Token* right_token);
+    TaggedValue unary_minus(TaggedValue value, Token* token);
+    TaggedValue negate(TaggedValue value, Token* token);
+
+    bool values_equal(TaggedValue left, TaggedValue right);
+    bool compare(TokenType op, TaggedValue left, TaggedValue right, Token* token);
+
+    TaggedValue cast(TaggedValue value, Token* type);
+
+    // Indexing, for arrays and maps. A map gives None for a missing key.
+    TaggedValue array_get(TaggedValue array, TaggedValue index, Token* array_token, Token* index_token);
+    void array_set(TaggedValue array, TaggedValue index, TaggedValue value, Token* array_token, Token* index_token);
+
+    void map_insert(Map* map, TaggedValue key, TaggedValue value, Token* key_token);
+    void map_delete(TaggedValue map, TaggedValue key, Token* map_token, Token* key_token);
+
+    // object:member = value. Instances have a fixed shape, so only
+    // existing members can be assigned.
+    void member_set(TaggedValue object, MemberCache* cache, TaggedValue value, Token* token);
+
+    // map:keys and map:values, as new arrays in insertion order.
+    TaggedValue map_member(TaggedValue map, std::string name, Token* token);
+
+    // Counted for loops. The bounds must be numbers and the step nonzero.
+    // The INT cases are inline, so a loop over INTs counts without a call.
+    void check_range(TaggedValue start, TaggedValue end, TaggedValue step, Token* token);
+    bool range_continues_slow(TaggedValue var, TaggedValue end, TaggedValue step, Token* token);
+
+    inline bool range_continues(TaggedValue var, TaggedValue end, TaggedValue step, Token* token) {
+        if(var.type == Type::INT && end.type == Type::INT && step.type == Type::INT) {
+            return step.integer > 0 ? var.integer < end.integer : var.integer > end.integer;
+        }
+        return range_continues_slow(var, end, step, token);
+    }
+
+    // Adds step to var in place. An INT that would overflow becomes a FLOAT.
+    inline void range_step(TaggedValue& var, TaggedValue step, Token* token) {
+        int64_t next;
+
+        if(var.type == Type::INT && step.type == Type::INT &&
+           !__builtin_add_overflow(var.integer, step.integer, &next))
+        {
+            var.integer = next;
+            return;
+        }
+        var = binary_op(TokenType::PLUS, var, step, token, token);
+    }
+
+    // What a for loop over value visits: an array itself, the keys of a map,
+    // or an iterable Handle, which produces its elements one at a time.
+    TaggedValue iterable(TaggedValue value, Token* token);
+}
+
+#endif
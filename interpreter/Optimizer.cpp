@@ -0,0 +1,454 @@
+#include "Optimizer.h"
+
+// Runs an operation at compile time. Errors are thrown back instead of
+// ending the process; a failed fold leaves the node to fail at run time.
+template<typename Operation>
+static bool try_fold(Operation operation, TaggedValue& result) {
+    bool deferred = Error::deferred;
+    Error::deferred = true;
+
+    try {
+        result = operation();
+    } catch(Error& error) {
+        Error::deferred = deferred;
+        return false;
+    }
+
+    Error::deferred = deferred;
+    return true;
+}
+
+AST* Optimizer::visit(AST* node) {
+    switch(node->kind) {
+        case NodeKind::BINARY_OPERATOR:
+            return visit_binary_op((BinaryOperator*) node);
+
+        case NodeKind::UNARY_OPERATOR:
+            return visit_unary_op((UnaryOperator*) node);
+
+        case NodeKind::COMPARE:
+            return visit_compare((Compare*) node);
+
+        case NodeKind::NEGATION:
+            return visit_negation((Negation*) node);
+
+        case NodeKind::DOUBLE_CONDITION:
+            return visit_double_condition((DoubleCondition*) node);
+
+        case NodeKind::CAST_VALUE:
+            return visit_cast_value((CastValue*) node);
+
+        case NodeKind::IF_CONDITION:
+            return visit_if_condition((IfCondition*) node);
+
+        case NodeKind::WHILE_LOOP:
+            return visit_while_loop((WhileLoop*) node);
+
+        case NodeKind::COMPOUND:
+            visit_compound((Compound*) node);
+            break;
+
+        case NodeKind::ASSIGN:
+        {
+            Assign* assign = (Assign*) node;
+            assign->left = visit(assign->left);
+            assign->right = visit(assign->right);
+            break;
+        }
+        case NodeKind::VARIABLE_DECLARATION:
+        {
+            for(Assign* assign : ((VariableDeclaration*) node)->assignments) {
+                assign->right = visit(assign->right);
+            }
+            break;
+        }
+        case NodeKind::PRINT:
+        {
+            Print* print = (Print*) node;
+            print->printable = visit(print->printable);
+            break;
+        }
+        case NodeKind::ARRAY_INIT:
+        {
+            for(AST*& element : ((ArrayInit*) node)->elements) {
+                element = visit(element);
+            }
+            break;
+        }
+        case NodeKind::ARRAY_ACCESS:
+        {
+            ArrayAccess* access = (ArrayAccess*) node;
+            access->array = visit(access->array);
+            access->index = visit(access->index);
+            break;
+        }
+        case NodeKind::MAP_INIT:
+        {
+            MapInit* map_init = (MapInit*) node;
+
+            for(size_t i = 0; i < map_init->keys.size(); i++) {
+                map_init->keys[i] = visit(map_init->keys[i]);
+                map_init->values[i] = visit(map_init->values[i]);
+            }
+            break;
+        }
+        case NodeKind::DELETE:
+            visit(((Delete*) node)->target);
+            break;
+
+        case NodeKind::FOR_LOOP:
+        {
+            ForLoop* for_loop = (ForLoop*) node;
+            for_loop->start = visit(for_loop->start);
+
+            if(for_loop->end != NULL) {
+                for_loop->end = visit(for_loop->end);
+            }
+
+            if(for_loop->step != NULL) {
+                for_loop->step = visit(for_loop->step);
+            }
+            visit_compound(for_loop->statement);
+            break;
+        }
+        case NodeKind::FUNCTION_INIT:
+        case NodeKind::CLASS_INIT:
+            visit_compound(((FunctionInit*) node)->block);
+            break;
+
+        case NodeKind::FUNCTION_CALL:
+        {
+            FunctionCall* call = (FunctionCall*) node;
+            call->function = visit(call->function);
+
+            for(AST*& param : call->params) {
+                param = visit(param);
+            }
+            break;
+        }
+        case NodeKind::RETURN:
+        {
+            Return* ret = (Return*) node;
+            ret->returnable = visit(ret->returnable);
+            break;
+        }
+        case NodeKind::OBJECT_DIVE:
+        {
+            ObjectDive* dive = (ObjectDive*) node;
+            dive->parent = visit(dive->parent);
+            break;
+        }
+        default:
+            break;
+    }
+
+    return node;
+}
+
+bool Optimizer::is_literal(AST* node) {
+    if(node->kind != NodeKind::VALUE) {
+        return false;
+    }
+
+    switch(node->token->type) {
+        case TokenType::FLOAT:
+        case TokenType::INT:
+        case TokenType::BOOLEAN:
+        case TokenType::STRING:
+        case TokenType::NONE:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+bool Optimizer::is_literal(AST* node, TokenType type) {
+    return is_literal(node) && node->token->type_of(type);
+}
+
+bool Optimizer::is_number(AST* node) {
+    return is_literal(node, TokenType::FLOAT) || is_literal(node, TokenType::INT);
+}
+
+// Strings are created unmanaged: the fold may run on a preload thread, and
+// the caller deletes them once the operation is done.
+TaggedValue Optimizer::literal_value(Value* val) {
+    switch(val->token->type) {
+        case TokenType::FLOAT:
+            return TaggedValue(val->number);
+
+        case TokenType::INT:
+            return TaggedValue(val->integer);
+
+        case TokenType::BOOLEAN:
+            return TaggedValue(val->value == Values::TRUE);
+
+        case TokenType::STRING:
+            return TaggedValue(new String(val->value));
+
+        default:
+            return TaggedValue::none();
+    }
+}
+
+AST* Optimizer::make_value(TaggedValue value, Token* position) {
+    TokenType type;
+    std::string text;
+
+    switch(value.type) {
+        case Type::FLOAT:
+            type = TokenType::FLOAT;
+            text = value.str();
+            break;
+
+        case Type::INT:
+            type = TokenType::INT;
+            text = value.str();
+            break;
+
+        case Type::BOOLEAN:
+            type = TokenType::BOOLEAN;
+            text = value.str();
+            break;
+
+        case Type::STRING:
+            type = TokenType::STRING;
+            text = ((String*) value.ref)->value;
+            break;
+
+        default:
+            type = TokenType::NONE;
+            text = Values::NONE;
+    }
+
+    Value* val = new Value(new Token(type, text, position->line, position->column, position->file));
+
+    if(value.type == Type::FLOAT) {
+        val->number = value.number;
+    } else if(value.type == Type::INT) {
+        val->integer = value.integer;
+    }
+    return val;
+}
+
+AST* Optimizer::visit_binary_op(BinaryOperator* op) {
+    op->left = visit(op->left);
+    op->right = visit(op->right);
+
+    if(is_literal(op->left, TokenType::STRING) && is_literal(op->right, TokenType::STRING) &&
+       op->op->type_of(TokenType::PLUS))
+    {
+        String result(((Value*) op->left)->value + ((Value*) op->right)->value);
+        return make_value(TaggedValue(&result), op->token);
+    }
+
+    if(!is_number(op->left) || !is_number(op->right)) {
+        return op;
+    }
+
+    TaggedValue left = literal_value((Value*) op->left);
+    TaggedValue right = literal_value((Value*) op->right);
+    TaggedValue result;
+
+    bool folded = try_fold([&] {
+        return Operations::binary_op(op->op->type, left, right, op->left->token, op->right->token);
+    }, result);
+
+    return folded ? make_value(result, op->token) : op;
+}
+
+AST* Optimizer::visit_unary_op(UnaryOperator* op) {
+    op->expr = visit(op->expr);
+
+    if(!is_number(op->expr)) {
+        return op;
+    }
+
+    if(op->op->type_of(TokenType::MINUS)) {
+        return make_value(Operations::unary_minus(literal_value((Value*) op->expr), op->token), op->token);
+    }
+    return op->expr;
+}
+
+AST* Optimizer::visit_compare(Compare* c) {
+    bool literals = true;
+
+    for(AST*& node : c->comparables) {
+        node = visit(node);
+        literals = literals && is_literal(node);
+    }
+
+    if(!literals) {
+        return c;
+    }
+
+    std::vector<TaggedValue> values;
+
+    for(AST* node : c->comparables) {
+        values.push_back(literal_value((Value*) node));
+    }
+
+    TaggedValue result;
+
+    bool folded = try_fold([&] {
+        for(size_t i = 0; i < c->operators.size(); i++) {
+            if(!Operations::compare(c->operators[i]->type, values[i], values[i + 1], c->comparables[i]->token)) {
+                return TaggedValue(false);
+            }
+        }
+        return TaggedValue(true);
+    }, result);
+
+    for(TaggedValue& value : values) {
+        if(value.is_heap()) {
+            delete value.ref;
+        }
+    }
+
+    return folded ? make_value(result, c->comparables[0]->token) : c;
+}
+
+AST* Optimizer::visit_negation(Negation* neg) {
+    neg->statement = visit(neg->statement);
+
+    if(!is_literal(neg->statement) || is_literal(neg->statement, TokenType::STRING)) {
+        return neg;
+    }
+
+    TaggedValue value = literal_value((Value*) neg->statement);
+    TaggedValue result;
+
+    bool folded = try_fold([&] {
+        return Operations::negate(value, neg->statement->token);
+    }, result);
+
+    return folded ? make_value(result, neg->token) : neg;
+}
+
+AST* Optimizer::visit_double_condition(DoubleCondition* cond) {
+    cond->left = visit(cond->left);
+    cond->right = visit(cond->right);
+
+    if(!is_literal(cond->left)) {
+        return cond;
+    }
+
+    bool left = is_literal(cond->left, TokenType::BOOLEAN) && ((Value*) cond->left)->value == Values::TRUE;
+    bool is_and = cond->op->type_of(TokenType::AND);
+
+    // A literal left operand that decides the result means the right one
+    // is never evaluated, whatever it is.
+    if(is_and ? !left : left) {
+        return make_value(TaggedValue(left), cond->token);
+    }
+
+    if(!is_literal(cond->right)) {
+        return cond;
+    }
+
+    bool right = is_literal(cond->right, TokenType::BOOLEAN) && ((Value*) cond->right)->value == Values::TRUE;
+
+    if(cond->op->type_of(TokenType::AND)) {
+        return make_value(TaggedValue(left && right), cond->token);
+    }
+    return make_value(TaggedValue(left || right), cond->token);
+}
+
+AST* Optimizer::visit_cast_value(CastValue* cast) {
+    cast->value = visit(cast->value);
+
+    if(!is_literal(cast->value)) {
+        return cast;
+    }
+
+    if(cast->type->type_of(TokenType::CAST_STRING)) {
+        if(is_literal(cast->value, TokenType::STRING)) {
+            return cast->value;
+        }
+
+        TaggedValue value = literal_value((Value*) cast->value);
+        String result(value.str());
+        return make_value(TaggedValue(&result), cast->token);
+    }
+
+    TaggedValue value = literal_value((Value*) cast->value);
+    TaggedValue result;
+
+    bool folded = try_fold([&] {
+        return Operations::cast(value, cast->type);
+    }, result);
+
+    if(value.is_heap()) {
+        delete value.ref;
+    }
+
+    return folded ? make_value(result, cast->token) : cast;
+}
+
+AST* Optimizer::visit_if_condition(IfCondition* cond) {
+    std::vector<IfCondition*> branches = { cond };
+    branches.insert(branches.end(), cond->elses.begin(), cond->elses.end());
+
+    std::vector<IfCondition*> reachable;
+
+    for(IfCondition* branch : branches) {
+        branch->condition = visit(branch->condition);
+        visit_compound(branch->statement);
+
+        if(!is_literal(branch->condition)) {
+            reachable.push_back(branch);
+            continue;
+        }
+
+        if(is_literal(branch->condition, TokenType::BOOLEAN) && ((Value*) branch->condition)->value == Values::TRUE) {
+            branch->condition = NULL;
+            reachable.push_back(branch);
+            break;
+        }
+    }
+
+    if(reachable.empty()) {
+        return new NoOperator();
+    }
+
+    IfCondition* first = reachable[0];
+    first->elses.assign(reachable.begin() + 1, reachable.end());
+
+    return first;
+}
+
+AST* Optimizer::visit_while_loop(WhileLoop* while_loop) {
+    while_loop->condition = visit(while_loop->condition);
+    visit_compound(while_loop->statement);
+
+    if(is_literal(while_loop->condition) && !is_literal(while_loop->condition, TokenType::BOOLEAN)) {
+        return new NoOperator();
+    }
+
+    if(is_literal(while_loop->condition, TokenType::BOOLEAN) && ((Value*) while_loop->condition)->value == Values::FALSE) {
+        return new NoOperator();
+    }
+
+    return while_loop;
+}
+
+void Optimizer::visit_compound(Compound* comp) {
+    std::vector<AST*> children;
+
+    for(AST* node : comp->children) {
+        node = visit(node);
+
+        if(node->kind == NodeKind::NO_OPERATOR) {
+            continue;
+        }
+
+        children.push_back(node);
+
+        if(node->kind == NodeKind::RETURN) {
+            break;
+        }
+    }
+
+    comp->children = children;
+}
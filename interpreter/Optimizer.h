@@ -0,0 +1,46 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "Memory.h"
+#include "Operations.h"
+#include "../parser/AST.h"
+#include "../utils/Values.h"
+#include "../utils/Error.h"
+
+// Rewrites an analyzed tree before it is executed or compiled.
+//
+// Operators, comparisons, negations and casts whose operands are all
+// literals are replaced by the resulting Value, as is an `and`/`or` whose
+// literal left operand already decides it. Anything that would raise
+// an error is left alone, so the error still happens at run time. Branches
+// of an if whose condition folds to False are dropped, a branch whose
+// condition folds to True loses its condition (as does every else, which
+// the Parser gives a literal True) and ends the chain, `while(False)` loops
+// disappear, and statements after a return are removed.
+//
+// Only creates values that need no heap allocation, so it is safe to run
+// on the threads that preload modules.
+class Optimizer {
+    public:
+        AST* visit(AST* node);
+
+    private:
+        AST* visit_binary_op(BinaryOperator* op);
+        AST* visit_unary_op(UnaryOperator* op);
+        AST* visit_compare(Compare* c);
+        AST* visit_negation(Negation* neg);
+        AST* visit_double_condition(DoubleCondition* cond);
+        AST* visit_cast_value(CastValue* cast);
+        AST* visit_if_condition(IfCondition* cond);
+        AST* visit_while_loop(WhileLoop* while_loop);
+
+        void visit_compound(Compound* comp);
+
+        bool is_literal(AST* node);
+        bool is_literal(AST* node, TokenType type);
+        bool is_number(AST* node);
+        TaggedValue literal_value(Value* val);
+        AST* make_value(TaggedValue value, Token* position);
+};
+
+#endif
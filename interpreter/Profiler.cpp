@@ -0,0 +1,325 @@
+#include "Profiler.h"
+#include "../utils/Output.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sys/time.h>
+
+Profiler profiler;
+
+static void on_tick(int signal) {
+    Profiler::tick = 1;
+}
+
+Profiler::Profiler() {
+    sampling = false;
+    counting = false;
+    interval_us = 1000;
+    samples = 0;
+}
+
+// SA_RESTART keeps the timer from failing reads and writes with EINTR.
+void Profiler::start_sampling(std::string output_path) {
+    this->output_path = output_path;
+    sampling = true;
+
+    struct sigaction action = {};
+    action.sa_handler = on_tick;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, NULL);
+
+    itimerval timer = {};
+    timer.it_interval.tv_usec = interval_us;
+    timer.it_value.tv_usec = interval_us;
+    setitimer(ITIMER_PROF, &timer, NULL);
+
+    std::atexit(report_samples);
+}
+
+void Profiler::start_counting(std::string output_path) {
+    this->output_path = output_path;
+    counting = true;
+
+    std::atexit(report_counts);
+}
+
+void Profiler::sample(Token* token) {
+    tick = 0;
+    samples++;
+    token_samples[token]++;
+    stack_samples[stack]++;
+}
+
+const std::string* Profiler::module_name(std::string path) {
+    size_t slash = path.find_last_of("\\/");
+    return &*names.insert(slash == std::string::npos ? path : path.substr(slash + 1)).first;
+}
+
+// Where a node is, for the kinds the Parser gives no token. NULL for nodes
+// without a position in the source, which are left unprobed.
+static Token* position(AST* node) {
+    if(node == NULL) {
+        return NULL;
+    }
+
+    if(node->token != NULL) {
+        return node->token->file.empty() ? NULL : node->token;
+    }
+
+    switch(node->kind) {
+        case NodeKind::COMPARE:
+            return position(((Compare*) node)->comparables[0]);
+
+        case NodeKind::FUNCTION_CALL:
+            return position(((FunctionCall*) node)->function);
+
+        case NodeKind::ARRAY_ACCESS:
+            return position(((ArrayAccess*) node)->array);
+
+        case NodeKind::IF_CONDITION:
+            return position(((IfCondition*) node)->condition);
+
+        case NodeKind::WHILE_LOOP:
+            return position(((WhileLoop*) node)->condition);
+
+        case NodeKind::PRINT:
+            return position(((Print*) node)->printable);
+
+        case NodeKind::VARIABLE_DECLARATION:
+            return position(((VariableDeclaration*) node)->variables[0]);
+
+        default:
+            return NULL;
+    }
+}
+
+// node in a Probe, if it has a position. A return outside a function is
+// left for the Interpreter to reject.
+AST* Profiler::probe(AST* node, bool inside_func) {
+    Token* token = position(node);
+
+    if(token == NULL || (node->kind == NodeKind::RETURN && !inside_func)) {
+        return node;
+    }
+
+    Probe* probe = new Probe(node, token);
+
+    if(counting) {
+        probes.push_back(probe);
+    }
+    return probe;
+}
+
+void Profiler::instrument(AST* node) {
+    switch(node->kind) {
+        case NodeKind::COMPOUND:
+            instrument_compound((Compound*) node);
+            break;
+
+        case NodeKind::IF_CONDITION:
+        {
+            IfCondition* cond = (IfCondition*) node;
+            std::vector<IfCondition*> branches = { cond };
+            branches.insert(branches.end(), cond->elses.begin(), cond->elses.end());
+
+            for(IfCondition* branch : branches) {
+                if(counting && branch->condition != NULL) {
+                    branch->condition = probe(branch->condition, false);
+                }
+                instrument_compound(branch->statement);
+            }
+            break;
+        }
+        case NodeKind::WHILE_LOOP:
+        {
+            WhileLoop* while_loop = (WhileLoop*) node;
+
+            if(counting) {
+                while_loop->condition = probe(while_loop->condition, false);
+            }
+            instrument_compound(while_loop->statement);
+            break;
+        }
+        case NodeKind::FOR_LOOP:
+            instrument_compound(((ForLoop*) node)->statement);
+            break;
+
+        case NodeKind::FUNCTION_INIT:
+        case NodeKind::CLASS_INIT:
+            instrument_compound(((FunctionInit*) node)->block);
+
+            if(counting) {
+                instrument_function((FunctionInit*) node);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void Profiler::instrument_compound(Compound* comp) {
+    for(AST*& child : comp->children) {
+        instrument(child);
+        child = probe(child, comp->inside_func);
+    }
+}
+
+// Moves the body into a nested block under a single probe, which then runs
+// once per call. Returns inside still end the call: the nested block sets
+// returning as the body would have.
+void Profiler::instrument_function(FunctionInit* func_init) {
+    Compound* block = func_init->block;
+    Token* token = block->children.empty() ? NULL : position(block->children[0]);
+
+    if(token == NULL) {
+        return;
+    }
+
+    Compound* body = new Compound(block->inside_func);
+    body->children = block->children;
+
+    Probe* probe = new Probe(body, token);
+    probe->function = func_init;
+    probes.push_back(probe);
+
+    block->children = { probe };
+}
+
+static std::vector<std::string>& source_lines(std::string file) {
+    static std::map<std::string, std::vector<std::string>> sources;
+
+    if(sources.find(file) == sources.end()) {
+        std::ifstream input(file);
+        std::string text;
+
+        while(std::getline(input, text)) {
+            sources[file].push_back(text);
+        }
+    }
+    return sources[file];
+}
+
+static std::string source_line(std::string file, int line) {
+    std::vector<std::string>& lines = source_lines(file);
+
+    if(line < 1 || line > (int) lines.size()) {
+        return "";
+    }
+
+    std::string text = lines[line - 1];
+    size_t start = text.find_first_not_of(" \t");
+    return start == std::string::npos ? "" : text.substr(start);
+}
+
+void Profiler::report_samples() {
+    itimerval timer = {};
+    setitimer(ITIMER_PROF, &timer, NULL);
+    output.flush();
+
+    std::map<std::pair<std::string, int>, size_t> line_samples;
+
+    for(auto& [token, count] : profiler.token_samples) {
+        line_samples[{ token->file, token->line }] += count;
+    }
+
+    std::vector<std::pair<size_t, std::pair<std::string, int>>> hottest;
+
+    for(auto& [line, count] : line_samples) {
+        hottest.push_back({ count, line });
+    }
+
+    std::sort(hottest.begin(), hottest.end(), [](auto& a, auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+
+    size_t samples = profiler.samples;
+
+    std::cerr << "Profile: " << samples << " samples, one per " << profiler.interval_us << " us of CPU time" << std::endl;
+    std::cerr << " samples       %  line" << std::endl;
+
+    for(size_t i = 0; i < hottest.size() && i < 20; i++) {
+        auto& [count, line] = hottest[i];
+        char columns[32];
+
+        snprintf(columns, sizeof(columns), "%8zu  %5.1f%%", count, 100.0 * count / samples);
+        std::cerr << columns << "  " << line.first << ":" << line.second << "  "
+                  << source_line(line.first, line.second) << std::endl;
+    }
+
+    std::ofstream stacks(profiler.output_path);
+
+    for(auto& [frames, count] : profiler.stack_samples) {
+        for(size_t i = 0; i < frames.size(); i++) {
+            stacks << (i > 0 ? ";" : "") << *frames[i];
+        }
+        stacks << " " << count << "\n";
+    }
+
+    std::cerr << "Profile: call stacks written to " << profiler.output_path << std::endl;
+}
+
+// A line shows the most runs and the longest time of the probes on it, so a
+// statement and a condition nested in it on the same line are not added up.
+// Function bodies are only listed by name.
+void Profiler::report_counts() {
+    output.flush();
+
+    std::map<std::string, std::map<int, std::pair<uint64_t, uint64_t>>> lines;
+    std::vector<Probe*> functions;
+
+    for(Probe* probe : profiler.probes) {
+        if(probe->function != NULL) {
+            functions.push_back(probe);
+            continue;
+        }
+
+        std::pair<uint64_t, uint64_t>& line = lines[probe->token->file][probe->token->line];
+        line.first = std::max(line.first, probe->count);
+        line.second = std::max(line.second, probe->nanoseconds);
+    }
+
+    std::ofstream listing(profiler.output_path);
+    char columns[64];
+
+    for(auto& [file, counts] : lines) {
+        std::vector<std::string>& source = source_lines(file);
+
+        snprintf(columns, sizeof(columns), "%10s %12s:%5d:", "-", "-", 0);
+        listing << columns << "Source:" << file << "\n";
+
+        for(size_t i = 0; i < source.size(); i++) {
+            auto line = counts.find(i + 1);
+
+            if(line == counts.end()) {
+                snprintf(columns, sizeof(columns), "%10s %12s:%5zu:", "-", "-", i + 1);
+            } else if(line->second.first == 0) {
+                snprintf(columns, sizeof(columns), "%10s %12s:%5zu:", "#####", "-", i + 1);
+            } else {
+                snprintf(columns, sizeof(columns), "%10llu %12.3f:%5zu:", (unsigned long long) line->second.first,
+                         line->second.second / 1e6, i + 1);
+            }
+            listing << columns << source[i] << "\n";
+        }
+    }
+
+    std::sort(functions.begin(), functions.end(), [](Probe* a, Probe* b) {
+        return a->nanoseconds > b->nanoseconds;
+    });
+
+    std::cerr << "Counts:      calls     total ms   ms per call  function" << std::endl;
+
+    for(Probe* probe : functions) {
+        double total = probe->nanoseconds / 1e6;
+
+        snprintf(columns, sizeof(columns), "%19llu %12.3f %13.6f", (unsigned long long) probe->count,
+                 total, probe->count > 0 ? total / probe->count : 0.0);
+        std::cerr << columns << "  " << probe->function->func_name << " (" << probe->token->file << ":"
+                  << probe->token->line << ")" << std::endl;
+    }
+
+    std::cerr << "Counts: annotated source written to " << profiler.output_path << std::endl;
+}
@@ -0,0 +1,79 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <csignal>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include "../lexer/Token.h"
+#include "../parser/AST.h"
+
+// Where the time goes in a Misty program, measured one of two ways.
+//
+// Sampling (--profile): a CPU timer raises tick every interval, and the
+// interpreter records where it is the next time it looks, from a point
+// where its own state is safe to read: the tree walker as a statement
+// starts or finishes (Probe nodes mark the statements), the VM before the
+// next instruction. At exit the hottest lines go to stderr and every
+// sampled call stack, as Misty function names, is written in the collapsed
+// format flame graph tools read.
+//
+// Counting (--count): the tree walker counts how often every statement,
+// loop or branch condition and function body ran and how long it took,
+// through the same probes. At exit the functions are listed on stderr and
+// every source file is written out annotated with its counts, like gcov.
+//
+// Neither costs anything when off: the walker's tree has no probes, and the
+// VM runs a copy of its loop without the check.
+class Profiler {
+    public:
+        inline static volatile sig_atomic_t tick = 0;
+
+        bool sampling;
+        bool counting;
+        int interval_us;
+
+        // Where the collapsed stacks or the annotated source go.
+        std::string output_path;
+
+        // Filled in by the interpreter before each sample: the module, then
+        // the function of every active call, outermost first.
+        std::vector<const std::string*> stack;
+
+        Profiler();
+
+        void start_sampling(std::string output_path);
+        void start_counting(std::string output_path);
+
+        // Records a sample at token for the current stack.
+        void sample(Token* token);
+
+        // The name a module has in stacks.
+        const std::string* module_name(std::string path);
+
+        // Wraps every statement in the tree in a Probe, and when counting
+        // every condition and function body as well.
+        void instrument(AST* node);
+
+    private:
+        size_t samples;
+        std::unordered_map<Token*, size_t> token_samples;
+        std::map<std::vector<const std::string*>, size_t> stack_samples;
+        std::set<std::string> names;
+
+        // Every probe made while counting.
+        std::vector<Probe*> probes;
+
+        AST* probe(AST* node, bool inside_func);
+        void instrument_compound(Compound* comp);
+        void instrument_function(FunctionInit* func_init);
+
+        static void report_samples();
+        static void report_counts();
+};
+
+extern Profiler profiler;
+
+#endif
@@ -1,78 +1,116 @@
 #include "SemanticAnalyzer.h"
 
 void SemanticAnalyzer::visit(AST* node) {
-    if(BinaryOperator* ast = dynamic_cast<BinaryOperator*>(node)) {
-        visit_binary_op(ast);
-
-    } else if(UnaryOperator* ast = dynamic_cast<UnaryOperator*>(node)) {
-        visit_unary_op(ast);
-
-    } else if(Value* ast = dynamic_cast<Value*>(node)) {
-         visit_value(ast);
-
-    } else if(Compare* ast = dynamic_cast<Compare*>(node)) {
-        visit_compare(ast);
-
-    } else if(Compound* ast = dynamic_cast<Compound*>(node)) {
-        visit_compound(ast);
-
-    } else if(Assign* ast = dynamic_cast<Assign*>(node)) {
-        visit_assign(ast);
-
-    } else if(Variable* ast = dynamic_cast<Variable*>(node)) {
-        visit_variable(ast);
-
-    } else if(NoOperator* ast = dynamic_cast<NoOperator*>(node)) {
-        visit_no_operator(ast);
-        
-    } else if(DoubleCondition* ast = dynamic_cast<DoubleCondition*>(node)) {
-        visit_double_condition(ast);
-        
-    } else if(Negation* ast = dynamic_cast<Negation*>(node)) {
-        visit_negation(ast);
-        
-    } else if(VariableDeclaration* ast = dynamic_cast<VariableDeclaration*>(node)) {
-        visit_var_declaration(ast);
-
-    } else if(IfCondition* ast = dynamic_cast<IfCondition*>(node)) {
-        visit_if_condition(ast);
-
-    } else if(Print* ast = dynamic_cast<Print*>(node)) {
-        visit_print(ast);
-
-    } else if(ArrayInit* ast = dynamic_cast<ArrayInit*>(node)) {
-        visit_array_init(ast);
-
-    } else if(ArrayAccess* ast = dynamic_cast<ArrayAccess*>(node)) {
-        visit_array_access(ast);
-
-    } else if(FunctionInit* ast = dynamic_cast<FunctionInit*>(node)) {
-        visit_function_init(ast);
-
-    } else if(FunctionCall* ast = dynamic_cast<FunctionCall*>(node)) {
-        visit_function_call(ast);
-
-    } else if(Return* ast = dynamic_cast<Return*>(node)) {
-        visit_return(ast);
-
-    } else if(WhileLoop* ast = dynamic_cast<WhileLoop*>(node)) {
-        visit_while_loop(ast);
-    
-    } else if(CastValue* ast = dynamic_cast<CastValue*>(node)) {
-        visit_cast_value(ast);
-        
-    } else if(Import* ast = dynamic_cast<Import*>(node)) {
-        visit_import(ast);
-
-    } else if(ObjectDive* ast = dynamic_cast<ObjectDive*>(node)) {
-        visit_object_dive(ast);
-
-    } else {
-        std::string message = "Unknown AST branch.";
-        int line = node->token->line;
-        int column = node->token->column;
-        std::string file_path = node->token->file;
-        Error(file_path, line, column, message).cast();
+    switch(node->kind) {
+        case NodeKind::BINARY_OPERATOR:
+            visit_binary_op((BinaryOperator*) node);
+            break;
+
+        case NodeKind::UNARY_OPERATOR:
+            visit_unary_op((UnaryOperator*) node);
+            break;
+
+        case NodeKind::VALUE:
+            visit_value((Value*) node);
+            break;
+
+        case NodeKind::COMPARE:
+            visit_compare((Compare*) node);
+            break;
+
+        case NodeKind::COMPOUND:
+            visit_compound((Compound*) node);
+            break;
+
+        case NodeKind::ASSIGN:
+            visit_assign((Assign*) node);
+            break;
+
+        case NodeKind::VARIABLE:
+            visit_variable((Variable*) node);
+            break;
+
+        case NodeKind::NO_OPERATOR:
+            visit_no_operator((NoOperator*) node);
+            break;
+
+        case NodeKind::DOUBLE_CONDITION:
+            visit_double_condition((DoubleCondition*) node);
+            break;
+
+        case NodeKind::NEGATION:
+            visit_negation((Negation*) node);
+            break;
+
+        case NodeKind::VARIABLE_DECLARATION:
+            visit_var_declaration((VariableDeclaration*) node);
+            break;
+
+        case NodeKind::IF_CONDITION:
+            visit_if_condition((IfCondition*) node);
+            break;
+
+        case NodeKind::PRINT:
+            visit_print((Print*) node);
+            break;
+
+        case NodeKind::ARRAY_INIT:
+            visit_array_init((ArrayInit*) node);
+            break;
+
+        case NodeKind::ARRAY_ACCESS:
+            visit_array_access((ArrayAccess*) node);
+            break;
+
+        case NodeKind::MAP_INIT:
+            visit_map_init((MapInit*) node);
+            break;
+
+        case NodeKind::DELETE:
+            visit_array_access(((Delete*) node)->target);
+            break;
+
+        case NodeKind::FUNCTION_INIT:
+        case NodeKind::CLASS_INIT:
+            visit_function_init((FunctionInit*) node);
+            break;
+
+        case NodeKind::FUNCTION_CALL:
+            visit_function_call((FunctionCall*) node);
+            break;
+
+        case NodeKind::RETURN:
+            visit_return((Return*) node);
+            break;
+
+        case NodeKind::WHILE_LOOP:
+            visit_while_loop((WhileLoop*) node);
+            break;
+
+        case NodeKind::FOR_LOOP:
+            visit_for_loop((ForLoop*) node);
+            break;
+
+        case NodeKind::CAST_VALUE:
+            visit_cast_value((CastValue*) node);
+            break;
+
+        case NodeKind::IMPORT:
+            visit_import((Import*) node);
+            break;
+
+        case NodeKind::OBJECT_DIVE:
+            visit_object_dive((ObjectDive*) node);
+            break;
+
+        default:
+        {
+            std::string message = "Unknown AST branch.";
+            int line = node->token->line;
+            int column = node->token->column;
+            std::string file_path = node->token->file;
+            Error(file_path, line, column, message).cast();
+        }
     }
 }
 
@@ -114,6 +152,7 @@ void SemanticAnalyzer::visit_compare(Compare* c) {
 void SemanticAnalyzer::visit_compound(Compound* comp) {
     if(current_scope == NULL) {
         current_scope = new SymbolTable(1, NULL);
+        comp->scope = current_scope;
     }
 
     for(AST* node : comp->children) {
@@ -123,16 +162,12 @@ void SemanticAnalyzer::visit_compound(Compound* comp) {
 
 void SemanticAnalyzer::visit_assign(Assign* assign) {
     AST* left = assign->left;
-    if(Variable* var = dynamic_cast<Variable*>(left)) {
-        std::string var_name = var->value;
-
-        Symbol* var_symbol = current_scope->lookup(var_name, false);
-
-        if(var_symbol == NULL) {
-            name_error(var->token);
-        }
-    } else if(ArrayAccess* arr_acc = dynamic_cast<ArrayAccess*>(left)) {
-        visit_array_access(arr_acc);
+    if(left->kind == NodeKind::VARIABLE) {
+        visit_variable((Variable*) left);
+    } else if(left->kind == NodeKind::ARRAY_ACCESS) {
+        visit_array_access((ArrayAccess*) left);
+    } else if(left->kind == NodeKind::OBJECT_DIVE) {
+        visit_object_dive((ObjectDive*) left);
     }
 
     visit(assign->right);
@@ -140,11 +175,13 @@ void SemanticAnalyzer::visit_assign(Assign* assign) {
 
 void SemanticAnalyzer::visit_variable(Variable* var) {
     std::string var_name = var->value;
-    Symbol* var_symbol = current_scope->lookup(var_name, false);
+    Symbol* var_symbol = current_scope->resolve(var_name, var->depth);
 
     if(var_symbol == NULL) {
         name_error(var->token);
     }
+
+    var->slot = var_symbol->slot;
 }
 
 void SemanticAnalyzer::visit_no_operator(NoOperator* no_op) {}
@@ -159,14 +196,19 @@ void SemanticAnalyzer::visit_negation(Negation* neg) {
 }
 
 void SemanticAnalyzer::visit_var_declaration(VariableDeclaration* decl) {
-    for(Variable* var : decl->variables) {
+    for(size_t i = 0; i < decl->variables.size(); i++) {
+        Variable* var = decl->variables[i];
         std::string name = var->value;
 
+        if(i < decl->assignments.size()) {
+            visit(decl->assignments[i]->right);
+        }
+
         if(current_scope->lookup(name, true) != NULL) {
             std::string message = "Variable "  + name + " has already been declared.";
             int line = var->token->line;
             int column = var->token->column;
-            std::string file_path;
+            std::string file_path = var->token->file;
 
             NameError(file_path, line, column, message).cast();
         }
@@ -174,15 +216,20 @@ void SemanticAnalyzer::visit_var_declaration(VariableDeclaration* decl) {
         Symbol* symbol = new Symbol(name);
 
         current_scope->define(symbol);
+
+        var->depth = 0;
+        var->slot = symbol->slot;
     }
 }
 
 void SemanticAnalyzer::visit_if_condition(IfCondition* cond) {
     visit(cond->condition);
+    visit_block(cond->statement);
 
-    enter_new_scope();
-    visit(cond->statement);
-    leave_scope();
+    for(IfCondition* else_ : cond->elses) {
+        visit(else_->condition);
+        visit_block(else_->statement);
+    }
 }
 
 void SemanticAnalyzer::visit_print(Print* print) {
@@ -200,15 +247,40 @@ void SemanticAnalyzer::visit_array_access(ArrayAccess* access) {
     visit(access->index);
 }
 
+void SemanticAnalyzer::visit_map_init(MapInit* map_init) {
+    for(size_t i = 0; i < map_init->keys.size(); i++) {
+        visit(map_init->keys[i]);
+        visit(map_init->values[i]);
+    }
+}
+
 void SemanticAnalyzer::visit_function_init(FunctionInit* func_init) {
     Symbol* func_symbol = new Symbol(func_init->func_name);
     current_scope->define(func_symbol);
+    func_init->slot = func_symbol->slot;
+
+    for(SymbolTable* scope = current_scope; scope != NULL; scope = scope->enclosing_scope) {
+        scope->captured = true;
+    }
 
     enter_new_scope();
+    func_init->scope = current_scope;
 
-    visit(func_init->params);
+    // An instance is its class's scope, so it always outlives the call.
+    if(func_init->kind == NodeKind::CLASS_INIT) {
+        current_scope->captured = true;
+    }
+
+    FunctionInit* enclosing_function = current_function;
+    current_function = func_init;
+
+    if(func_init->params != NULL) {
+        visit(func_init->params);
+        func_init->arity = func_init->params->variables.size();
+    }
     visit(func_init->block);
 
+    current_function = enclosing_function;
     leave_scope();
 }
 
@@ -220,15 +292,18 @@ void SemanticAnalyzer::visit_function_call(FunctionCall* func_call) {
 }
 
 void SemanticAnalyzer::visit_return(Return* ret) {
+    if(current_function != NULL && current_function->kind == NodeKind::CLASS_INIT) {
+        std::string message = "Return statement inside a class body.";
+        Token* token = ret->token;
+        SyntaxError(token->file, token->line, token->column, message).cast();
+    }
+
     visit(ret->returnable);
 }
 
 void SemanticAnalyzer::visit_while_loop(WhileLoop* while_loop) {
     visit(while_loop->condition);
-
-    enter_new_scope();
-    visit(while_loop->statement);
-    leave_scope();
+    visit_block(while_loop->statement);
 }
 
 void SemanticAnalyzer::visit_cast_value(CastValue* cast) {
@@ -238,9 +313,69 @@ void SemanticAnalyzer::visit_cast_value(CastValue* cast) {
 void SemanticAnalyzer::visit_import(Import* import) {
     Symbol* import_name = new Symbol(import->name);
     current_scope->define(import_name);
+    import->slot = import_name->slot;
 }
 
 void SemanticAnalyzer::visit_object_dive(ObjectDive* dive) {
+    // The child is looked up in the object's own memory at runtime.
+    dive->cache = new MemberCache(dive->child->value);
     visit(dive->parent);
-    visit(dive->child);
+}
+
+bool SemanticAnalyzer::declares_names(Compound* comp) {
+    for(AST* node : comp->children) {
+        switch(node->kind) {
+            case NodeKind::VARIABLE_DECLARATION:
+            case NodeKind::FUNCTION_INIT:
+            case NodeKind::CLASS_INIT:
+            case NodeKind::IMPORT:
+                return true;
+
+            default:
+                break;
+        }
+    }
+    return false;
+}
+
+// The bounds belong to the enclosing scope; the variable and the hidden
+// state, whose names are not identifiers, to the loop's own.
+void SemanticAnalyzer::visit_for_loop(ForLoop* for_loop) {
+    visit(for_loop->start);
+
+    if(for_loop->end != NULL) {
+        visit(for_loop->end);
+    }
+
+    if(for_loop->step != NULL) {
+        visit(for_loop->step);
+    }
+
+    enter_new_scope();
+    for_loop->scope = current_scope;
+
+    Variable* var = for_loop->variable;
+    Symbol* symbol = new Symbol(var->value);
+
+    current_scope->define(symbol);
+    current_scope->define(new Symbol("for bound"));
+    current_scope->define(new Symbol("for step"));
+
+    var->depth = 0;
+    var->slot = symbol->slot;
+
+    visit_block(for_loop->statement);
+    leave_scope();
+}
+
+void SemanticAnalyzer::visit_block(Compound* comp) {
+    if(!declares_names(comp)) {
+        visit(comp);
+        return;
+    }
+
+    enter_new_scope();
+    comp->scope = current_scope;
+    visit(comp);
+    leave_scope();
 }
\ No newline at end of file
@@ -11,8 +11,12 @@ class SemanticAnalyzer {
 
         SymbolTable* current_scope;
 
+        // Innermost function or class being analyzed, NULL at top level.
+        FunctionInit* current_function;
+
         SemanticAnalyzer() {
             current_scope = NULL;
+            current_function = NULL;
         }
 
         void visit(AST* node);
@@ -36,14 +40,19 @@ class SemanticAnalyzer {
         void visit_print(Print* print);
         void visit_array_init(ArrayInit* array_init);
         void visit_array_access(ArrayAccess* access);
+        void visit_map_init(MapInit* map_init);
         void visit_function_init(FunctionInit* func_init);
         void visit_function_call(FunctionCall* func_call);
         void visit_return(Return* ret);
         void visit_while_loop(WhileLoop* while_loop);
+        void visit_for_loop(ForLoop* for_loop);
         void visit_cast_value(CastValue* cast);
         void visit_import(Import* import);
         void visit_object_dive(ObjectDive* dive);
 
+        void visit_block(Compound* comp);
+        bool declares_names(Compound* comp);
+
         void name_error(Token* token);
 };
 
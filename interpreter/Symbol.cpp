@@ -3,9 +3,22 @@
 SymbolTable::SymbolTable(int scope_level, SymbolTable* enclosing_scope) {
     this->scope_level = scope_level;
     this->enclosing_scope = enclosing_scope;
+    this->captured = false;
+}
+
+int SymbolTable::size() {
+    return symbols.size();
 }
 
 void SymbolTable::define(Symbol* symbol) {
+    std::map<std::string, Symbol*>::iterator it = symbols.find(symbol->name);
+
+    if(it != symbols.end()) {
+        symbol->slot = it->second->slot;
+    } else {
+        symbol->slot = symbols.size();
+    }
+
     symbols[symbol->name] = symbol;
 }
 
@@ -21,6 +34,24 @@ Symbol* SymbolTable::lookup(std::string name, bool only_this_scope) {
     return NULL;
 }
 
+Symbol* SymbolTable::resolve(std::string name, int& depth) {
+    SymbolTable* scope = this;
+    depth = 0;
+
+    while(scope != NULL) {
+        std::map<std::string, Symbol*>::iterator it = scope->symbols.find(name);
+
+        if(it != scope->symbols.end()) {
+            return it->second;
+        }
+
+        scope = scope->enclosing_scope;
+        depth++;
+    }
+
+    return NULL;
+}
+
 std::string SymbolTable::str() {
     std::string result = "Symbols: \n";
 
@@ -7,26 +7,72 @@
 class Symbol {
     public:
         std::string name;
+        int slot;
 
         Symbol(std::string name) {
             this->name = name;
+            this->slot = -1;
         }
 
 };
 
+// One lexical scope. Symbols are numbered in order of definition, and the
+// runtime Memory for the scope is a flat array of that many slots.
 class SymbolTable {
     public:
         int scope_level;
         SymbolTable* enclosing_scope;
 
+        // Set when a function is defined in this scope or a nested one, so
+        // the scope's Memory may outlive the block as part of a closure.
+        bool captured;
+
         std::map<std::string, Symbol*> symbols;
 
         SymbolTable(int scope_level, SymbolTable* enclosing_scope);
 
         std::string str();
 
+        int size();
+
         void define(Symbol* symbol);
         Symbol* lookup(std::string name, bool only_this_scope);
+        Symbol* resolve(std::string name, int& depth);
+};
+
+// Remembers where one `object:member` access last found its member. Layouts
+// never change once analyzed, so an object with the remembered layout has
+// the member in the same slot; any other layout misses and refills the
+// cache.
+class MemberCache {
+    public:
+        std::string name;
+        SymbolTable* layout;
+        int slot;
+
+        MemberCache(std::string name) {
+            this->name = name;
+            this->layout = NULL;
+            this->slot = -1;
+        }
+
+        // Slot of the member in an object with the given layout, or -1 when
+        // the object has no such member.
+        int lookup(SymbolTable* layout) {
+            if(layout == this->layout) {
+                return slot;
+            }
+
+            Symbol* symbol = layout->lookup(name, true);
+
+            if(symbol == NULL) {
+                return -1;
+            }
+
+            this->layout = layout;
+            this->slot = symbol->slot;
+            return slot;
+        }
 };
 
-#endif
\ No newline at end of file
+#endif
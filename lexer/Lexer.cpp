@@ -1,15 +1,16 @@
 #include "Lexer.h"
 
 #include <iostream>
+#include <charconv>
 
 Lexer::Lexer(std::string path) {
     this->path = path;
 
     std::ifstream input_file(path);
 
-    std::string line;
-    while(std::getline(input_file, line)) {
-        code += line + '\n'; 
+    std::string text;
+    while(std::getline(input_file, text)) {
+        code += text + '\n'; 
     }
 
     pos = 0;
@@ -45,6 +46,10 @@ void Lexer::create_keywords() {
     keywords["class"] = TokenType::CLASS;
     keywords["as"] = TokenType::AS;
     keywords["import"] = TokenType::IMPORT;
+    keywords["delete"] = TokenType::DELETE;
+    keywords["in"] = TokenType::IN;
+    keywords["to"] = TokenType::TO;
+    keywords["by"] = TokenType::BY;
 
     keywords[";"] = TokenType::SEMICOLON;
     keywords[":"] = TokenType::COLON;
@@ -122,9 +127,19 @@ Token* Lexer::number() {
             result += current_char;
             advance();
         }
+
+        return create_token(TokenType::FLOAT, result);
+    }
+
+    // Integer literals too large for int64 are read as floats.
+    int64_t integer;
+    std::from_chars_result parsed = std::from_chars(result.data(), result.data() + result.size(), integer);
+
+    if(parsed.ec != std::errc()) {
+        return create_token(TokenType::FLOAT, result);
     }
     
-    return create_token(TokenType::FLOAT, result);
+    return create_token(TokenType::INT, result);
 }
 
 Token* Lexer::string() {
@@ -153,7 +168,7 @@ Token* Lexer::handle_identifiers() {
     }
 
     if(keywords.find(result) != keywords.end()) {
-        std::map<std::__cxx11::string, TokenType>::iterator it = keywords.find(result);
+        std::map<std::string, TokenType>::iterator it = keywords.find(result);
 
         return create_token(it->second, it->first);
     }
@@ -5,6 +5,7 @@
 
 enum class TokenType { 
     FLOAT,
+    INT,
     PLUS,
     MINUS,
     DIV,
@@ -50,6 +51,10 @@ enum class TokenType {
     CLASS, 
     AS, 
     IMPORT,
+    DELETE,
+    IN,
+    TO,
+    BY,
     BUILT_IN_LIB
 };
 
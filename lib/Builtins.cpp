@@ -0,0 +1,36 @@
+#include "Builtins.h"
+
+TaggedValue Builtins::load(Token* name) {
+    if(name->value == "math") {
+        return math();
+    }
+
+    if(name->value == "io") {
+        return io();
+    }
+
+    std::string message = "Built-in library $" + name->value + " not found.";
+    ImportError(name->file, name->line, name->column, message).cast();
+    return TaggedValue();
+}
+
+TaggedValue Builtins::make_library(std::vector<Member> members) {
+    SymbolTable* layout = new SymbolTable(0, NULL);
+
+    for(Member& member : members) {
+        layout->define(new Symbol(member.name));
+    }
+
+    Memory* memory = heap.track(new Memory(layout, NULL));
+
+    for(Member& member : members) {
+        int slot = layout->lookup(member.name, true)->slot;
+        memory->slots[slot] = TaggedValue(heap.track(new NativeFunction(member.name, member.arity, member.code)));
+    }
+
+    return TaggedValue(heap.track(new Object(memory)));
+}
+
+void Builtins::argument_error(Token* token, std::string message) {
+    ValueError(token->file, token->line, token->column, message).cast();
+}
@@ -0,0 +1,35 @@
+#ifndef BUILTINS_H
+#define BUILTINS_H
+
+#include <string>
+#include <vector>
+#include "../interpreter/Memory.h"
+#include "../interpreter/Heap.h"
+#include "../interpreter/Symbol.h"
+#include "../lexer/Token.h"
+#include "../utils/Error.h"
+
+// Libraries written in C++ and imported with `import $name as x;`. A
+// library is an Object whose members are NativeFunctions; it is built on
+// the first import and shared by every later one.
+namespace Builtins {
+    struct Member {
+        std::string name;
+        int arity;
+        NativeCode code;
+    };
+
+    // The library named by an import token. Raises an ImportError when
+    // there is no such library.
+    TaggedValue load(Token* name);
+
+    TaggedValue make_library(std::vector<Member> members);
+
+    // Raised by a native function called with arguments it cannot take.
+    void argument_error(Token* token, std::string message);
+
+    TaggedValue math();
+    TaggedValue io();
+}
+
+#endif
@@ -0,0 +1,340 @@
+#include "Builtins.h"
+#include <set>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static void io_error(Token* token, std::string message) {
+    IOError(token->file, token->line, token->column, message).cast();
+}
+
+// A file mapped into memory and read from the start. Lines are found in
+// the mapping itself, so the only copy of a line is the String it becomes,
+// and pages behind the cursor are handed back to the kernel as it moves,
+// which keeps memory use flat however large the file is.
+class MappedFile : public Handle {
+    public:
+        std::string path;
+        const char* data;
+        size_t length;
+        size_t position;
+        size_t released;
+        bool closed;
+
+        // Bytes read past the last release before the next one.
+        static constexpr size_t release_size = 16 * 1024 * 1024;
+
+        MappedFile(std::string path, const char* data, size_t length) {
+            this->path = path;
+            this->data = data;
+            this->length = length;
+            this->position = 0;
+            this->released = 0;
+            this->closed = false;
+        }
+
+        bool iterable() override {
+            return true;
+        }
+
+        bool next(TaggedValue& value) override {
+            if(closed || position >= length) {
+                return false;
+            }
+
+            const char* start = data + position;
+            const char* newline = (const char*) memchr(start, '\n', length - position);
+            size_t end = newline != NULL ? newline - data : length;
+            size_t line_end = end;
+
+            if(line_end > position && data[line_end - 1] == '\r') {
+                line_end--;
+            }
+
+            value = TaggedValue(heap.track(new String(std::string(start, line_end - position))));
+            position = newline != NULL ? end + 1 : end;
+
+            if(position - released >= release_size) {
+                size_t pages = (position - released) & ~((size_t) sysconf(_SC_PAGESIZE) - 1);
+                madvise((void*) (data + released), pages, MADV_DONTNEED);
+                released += pages;
+            }
+            return true;
+        }
+
+        std::string rest() {
+            if(closed || position >= length) {
+                return "";
+            }
+
+            std::string text(data + position, length - position);
+            position = length;
+            return text;
+        }
+
+        void close() {
+            if(!closed && length > 0) {
+                munmap((void*) data, length);
+            }
+            closed = true;
+        }
+
+        std::string str() override {
+            return "file " + path;
+        }
+
+        size_t size() override {
+            return sizeof(MappedFile) + path.capacity();
+        }
+
+        ~MappedFile() override {
+            close();
+        }
+};
+
+// A file written through a buffer that goes out in one write call once it
+// holds flush_size bytes. Writers still open when the program ends are
+// flushed at exit, including when it ends with an error.
+class FileWriter : public Handle {
+    public:
+        std::string path;
+        std::string buffer;
+        int fd;
+
+        static constexpr size_t flush_size = 64 * 1024;
+
+        inline static std::set<FileWriter*> open_writers;
+
+        FileWriter(std::string path, int fd) {
+            this->path = path;
+            this->fd = fd;
+
+            static bool registered = false;
+
+            if(!registered) {
+                std::atexit(flush_open_writers);
+                registered = true;
+            }
+            open_writers.insert(this);
+        }
+
+        bool write(TaggedValue value, bool end_line) {
+            if(fd < 0) {
+                return false;
+            }
+
+            value.write(buffer);
+
+            if(end_line) {
+                buffer += '\n';
+            }
+
+            if(buffer.size() >= flush_size) {
+                return flush();
+            }
+            return true;
+        }
+
+        bool flush() {
+            size_t written = 0;
+
+            while(written < buffer.size()) {
+                ssize_t count = ::write(fd, buffer.data() + written, buffer.size() - written);
+
+                if(count < 0 && errno == EINTR) {
+                    continue;
+                }
+
+                if(count < 0) {
+                    buffer.clear();
+                    return false;
+                }
+                written += count;
+            }
+            buffer.clear();
+            return true;
+        }
+
+        bool close() {
+            if(fd < 0) {
+                return true;
+            }
+
+            bool flushed = flush();
+            flushed = ::close(fd) == 0 && flushed;
+            fd = -1;
+            open_writers.erase(this);
+            return flushed;
+        }
+
+        static void flush_open_writers() {
+            for(FileWriter* writer : open_writers) {
+                writer->flush();
+            }
+        }
+
+        std::string str() override {
+            return "file " + path;
+        }
+
+        size_t size() override {
+            return sizeof(FileWriter) + path.capacity() + buffer.capacity();
+        }
+
+        ~FileWriter() override {
+            close();
+        }
+};
+
+static std::string as_path(TaggedValue value, Token* token, std::string function) {
+    if(value.type != Type::STRING) {
+        Builtins::argument_error(token, function + " expects a path.");
+    }
+    return ((String*) value.ref)->value;
+}
+
+static MappedFile* as_reader(TaggedValue value, Token* token, std::string function) {
+    MappedFile* file = value.type == Type::HANDLE ? dynamic_cast<MappedFile*>((Handle*) value.ref) : NULL;
+
+    if(file == NULL) {
+        Builtins::argument_error(token, function + " expects a file opened with open.");
+    }
+    return file;
+}
+
+static FileWriter* as_writer(TaggedValue value, Token* token, std::string function) {
+    FileWriter* writer = value.type == Type::HANDLE ? dynamic_cast<FileWriter*>((Handle*) value.ref) : NULL;
+
+    if(writer == NULL) {
+        Builtins::argument_error(token, function + " expects a file opened with create or append.");
+    }
+    return writer;
+}
+
+static MappedFile* map_file(std::string path, Token* token) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat info;
+
+    if(fd < 0) {
+        io_error(token, "Could not open " + path + ": " + strerror(errno) + ".");
+    }
+
+    if(fstat(fd, &info) < 0 || S_ISDIR(info.st_mode)) {
+        ::close(fd);
+        io_error(token, "Could not read " + path + ": it is not a file.");
+    }
+
+    size_t length = info.st_size;
+    void* data = NULL;
+
+    if(length > 0) {
+        data = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if(data == MAP_FAILED) {
+            int error = errno;
+            ::close(fd);
+            io_error(token, "Could not map " + path + ": " + strerror(error) + ".");
+        }
+        madvise(data, length, MADV_SEQUENTIAL);
+    }
+
+    ::close(fd);
+    return new MappedFile(path, (const char*) data, length);
+}
+
+static TaggedValue open_writer(std::string path, int flags, Token* token) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | flags, 0644);
+
+    if(fd < 0) {
+        io_error(token, "Could not open " + path + " for writing: " + strerror(errno) + ".");
+    }
+    return TaggedValue(heap.track(new FileWriter(path, fd)));
+}
+
+// A file for reading. A for loop over it visits its lines, without their
+// line endings.
+static TaggedValue io_open(TaggedValue* args, int argc, Token* token) {
+    return TaggedValue(heap.track(map_file(as_path(args[0], token, "open"), token)));
+}
+
+static TaggedValue io_create(TaggedValue* args, int argc, Token* token) {
+    return open_writer(as_path(args[0], token, "create"), O_TRUNC, token);
+}
+
+static TaggedValue io_append(TaggedValue* args, int argc, Token* token) {
+    return open_writer(as_path(args[0], token, "append"), O_APPEND, token);
+}
+
+// The next line of a file, or None after the last one.
+static TaggedValue io_read_line(TaggedValue* args, int argc, Token* token) {
+    TaggedValue line;
+
+    if(!as_reader(args[0], token, "read_line")->next(line)) {
+        return TaggedValue::none();
+    }
+    return line;
+}
+
+// The rest of an open file, or all of the file at a path.
+static TaggedValue io_read(TaggedValue* args, int argc, Token* token) {
+    if(args[0].type == Type::STRING) {
+        MappedFile* file = map_file(((String*) args[0].ref)->value, token);
+        std::string text = file->rest();
+
+        delete file;
+        return TaggedValue(heap.track(new String(text)));
+    }
+    return TaggedValue(heap.track(new String(as_reader(args[0], token, "read")->rest())));
+}
+
+static TaggedValue write_value(TaggedValue* args, Token* token, std::string function, bool end_line) {
+    FileWriter* writer = as_writer(args[0], token, function);
+
+    if(!writer->write(args[1], end_line)) {
+        io_error(token, "Could not write to " + writer->path + ".");
+    }
+    return TaggedValue::none();
+}
+
+static TaggedValue io_write(TaggedValue* args, int argc, Token* token) {
+    return write_value(args, token, "write", false);
+}
+
+static TaggedValue io_write_line(TaggedValue* args, int argc, Token* token) {
+    return write_value(args, token, "write_line", true);
+}
+
+static TaggedValue io_close(TaggedValue* args, int argc, Token* token) {
+    if(args[0].type != Type::HANDLE) {
+        Builtins::argument_error(token, "close expects a file.");
+    }
+
+    if(MappedFile* file = dynamic_cast<MappedFile*>((Handle*) args[0].ref)) {
+        file->close();
+        return TaggedValue::none();
+    }
+
+    FileWriter* writer = as_writer(args[0], token, "close");
+
+    if(!writer->close()) {
+        io_error(token, "Could not write to " + writer->path + ".");
+    }
+    return TaggedValue::none();
+}
+
+TaggedValue Builtins::io() {
+    return make_library({
+        { "open", 1, io_open },
+        { "create", 1, io_create },
+        { "append", 1, io_append },
+        { "read_line", 1, io_read_line },
+        { "read", 1, io_read },
+        { "write", 2, io_write },
+        { "write_line", 2, io_write_line },
+        { "close", 1, io_close },
+    });
+}
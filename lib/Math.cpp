@@ -0,0 +1,301 @@
+#include "Builtins.h"
+#include "../interpreter/Operations.h"
+#include "../interpreter/ArrayKernels.h"
+#include <cmath>
+
+typedef void (*Kernel)(const double* values, double* out, size_t n);
+
+static void number_error(Token* token, std::string function) {
+    Builtins::argument_error(token, function + " expects a number or an array of numbers.");
+}
+
+static Array* as_array(TaggedValue value, Token* token, std::string function) {
+    if(value.type != Type::ARRAY) {
+        Builtins::argument_error(token, function + " expects an array.");
+    }
+    return (Array*) value.ref;
+}
+
+// The elements of a packed array as doubles. INT arrays are converted into
+// spare; FLOAT arrays are used in place.
+static const double* packed_numbers(Array* array, std::vector<double>& spare) {
+    if(array->packing == Type::FLOAT) {
+        return array->numbers.data();
+    }
+
+    spare.assign(array->integers.begin(), array->integers.end());
+    return spare.data();
+}
+
+static void exp_kernel(const double* values, double* out, size_t n) {
+    for(size_t i = 0; i < n; i++) {
+        out[i] = std::exp(values[i]);
+    }
+}
+
+static void log_kernel(const double* values, double* out, size_t n) {
+    for(size_t i = 0; i < n; i++) {
+        out[i] = std::log(values[i]);
+    }
+}
+
+// f of a number, or a new array with f of every element. A packed array
+// is handed to kernel in one piece; a boxed one is mapped element by
+// element, so nested arrays work too.
+static TaggedValue map_numbers(TaggedValue value, double (*f)(double), Kernel kernel, Token* token, std::string function) {
+    if(value.is_number()) {
+        return TaggedValue(f(value.as_double()));
+    }
+
+    if(value.type != Type::ARRAY) {
+        number_error(token, function);
+    }
+
+    Array* array = (Array*) value.ref;
+    size_t n = array->length();
+
+    if(array->packing == Type::EMPTY) {
+        std::vector<TaggedValue> results;
+
+        for(size_t i = 0; i < n; i++) {
+            results.push_back(map_numbers(array->get(i), f, kernel, token, function));
+        }
+        return TaggedValue(heap.track(new Array(results)));
+    }
+
+    std::vector<double> spare;
+    Array* result = new Array(Type::FLOAT, n);
+
+    kernel(packed_numbers(array, spare), result->numbers.data(), n);
+    return TaggedValue(heap.track(result));
+}
+
+static double sqrt_of(double x) {
+    return std::sqrt(x);
+}
+
+static double exp_of(double x) {
+    return std::exp(x);
+}
+
+static double log_of(double x) {
+    return std::log(x);
+}
+
+static double floor_of(double x) {
+    return std::floor(x);
+}
+
+static TaggedValue math_sqrt(TaggedValue* args, int argc, Token* token) {
+    return map_numbers(args[0], sqrt_of, ArrayKernels::sqrt, token, "sqrt");
+}
+
+static TaggedValue math_exp(TaggedValue* args, int argc, Token* token) {
+    return map_numbers(args[0], exp_of, exp_kernel, token, "exp");
+}
+
+static TaggedValue math_log(TaggedValue* args, int argc, Token* token) {
+    return map_numbers(args[0], log_of, log_kernel, token, "log");
+}
+
+// INTs, and arrays packed as INT, are already whole and come back as they
+// are (an array as a copy).
+static TaggedValue math_floor(TaggedValue* args, int argc, Token* token) {
+    TaggedValue value = args[0];
+
+    if(value.type == Type::INT) {
+        return value;
+    }
+
+    if(value.type == Type::ARRAY && ((Array*) value.ref)->packing == Type::INT) {
+        Array* result = new Array(Type::INT, 0);
+        result->integers = ((Array*) value.ref)->integers;
+        return TaggedValue(heap.track(result));
+    }
+
+    return map_numbers(value, floor_of, ArrayKernels::floor, token, "floor");
+}
+
+// INT to the power of a non-negative INT stays an INT unless it overflows.
+static TaggedValue power(TaggedValue base, TaggedValue exponent, Token* token) {
+    if(!base.is_number() || !exponent.is_number()) {
+        number_error(token, "pow");
+    }
+
+    if(base.type == Type::INT && exponent.type == Type::INT && exponent.integer >= 0) {
+        int64_t result = 1;
+        int64_t factor = base.integer;
+        int64_t remaining = exponent.integer;
+        bool overflow = false;
+
+        while(remaining > 0 && !overflow) {
+            if(remaining & 1) {
+                overflow = __builtin_mul_overflow(result, factor, &result);
+            }
+
+            remaining >>= 1;
+
+            if(remaining > 0) {
+                overflow = overflow || __builtin_mul_overflow(factor, factor, &factor);
+            }
+        }
+
+        if(!overflow) {
+            return TaggedValue(result);
+        }
+    }
+
+    return TaggedValue(std::pow(base.as_double(), exponent.as_double()));
+}
+
+// With an array base, every element is raised to the exponent.
+static TaggedValue math_pow(TaggedValue* args, int argc, Token* token) {
+    TaggedValue base = args[0];
+    TaggedValue exponent = args[1];
+
+    if(base.type != Type::ARRAY) {
+        return power(base, exponent, token);
+    }
+
+    Array* array = (Array*) base.ref;
+    size_t n = array->length();
+
+    if(array->packing == Type::FLOAT && exponent.is_number()) {
+        Array* result = new Array(Type::FLOAT, n);
+        double y = exponent.as_double();
+
+        for(size_t i = 0; i < n; i++) {
+            result->numbers[i] = std::pow(array->numbers[i], y);
+        }
+        return TaggedValue(heap.track(result));
+    }
+
+    std::vector<TaggedValue> results;
+
+    for(size_t i = 0; i < n; i++) {
+        results.push_back(power(array->get(i), exponent, token));
+    }
+    return TaggedValue(heap.track(new Array(results)));
+}
+
+static TaggedValue math_sum(TaggedValue* args, int argc, Token* token) {
+    Array* array = as_array(args[0], token, "sum");
+    size_t n = array->length();
+
+    if(array->packing == Type::INT) {
+        int64_t total;
+
+        if(ArrayKernels::sum(array->integers.data(), n, total)) {
+            return TaggedValue(total);
+        }
+    }
+
+    if(array->packing != Type::EMPTY) {
+        std::vector<double> spare;
+        return TaggedValue(ArrayKernels::sum(packed_numbers(array, spare), n));
+    }
+
+    TaggedValue total((int64_t) 0);
+
+    for(size_t i = 0; i < n; i++) {
+        total = Operations::binary_op(TokenType::PLUS, total, array->get(i), token, token);
+    }
+    return total;
+}
+
+static TaggedValue math_dot(TaggedValue* args, int argc, Token* token) {
+    Array* a = as_array(args[0], token, "dot");
+    Array* b = as_array(args[1], token, "dot");
+    size_t n = a->length();
+
+    if(b->length() != n) {
+        Builtins::argument_error(token, "dot expects two arrays of the same length.");
+    }
+
+    if(a->packing == Type::EMPTY || b->packing == Type::EMPTY) {
+        if(n > 0) {
+            Builtins::argument_error(token, "dot expects two arrays of numbers.");
+        }
+        return TaggedValue((int64_t) 0);
+    }
+
+    if(a->packing == Type::INT && b->packing == Type::INT) {
+        int64_t total = 0;
+        bool overflow = false;
+
+        for(size_t i = 0; i < n && !overflow; i++) {
+            int64_t product;
+            overflow = __builtin_mul_overflow(a->integers[i], b->integers[i], &product) ||
+                       __builtin_add_overflow(total, product, &total);
+        }
+
+        if(!overflow) {
+            return TaggedValue(total);
+        }
+    }
+
+    std::vector<double> spare_a, spare_b;
+    return TaggedValue(ArrayKernels::dot(packed_numbers(a, spare_a), packed_numbers(b, spare_b), n));
+}
+
+// min and max take one array, or two or more numbers.
+template<bool maximum>
+static TaggedValue extreme(TaggedValue* args, int argc, Token* token) {
+    std::string function = maximum ? "max" : "min";
+    TokenType better = maximum ? TokenType::MORE : TokenType::LESS;
+
+    if(argc == 1) {
+        Array* array = as_array(args[0], token, function);
+        size_t n = array->length();
+
+        if(n == 0) {
+            Builtins::argument_error(token, function + " of an empty array.");
+        }
+
+        if(array->packing == Type::INT) {
+            return TaggedValue(maximum ? ArrayKernels::max(array->integers.data(), n)
+                                       : ArrayKernels::min(array->integers.data(), n));
+        }
+
+        if(array->packing == Type::FLOAT) {
+            return TaggedValue(maximum ? ArrayKernels::max(array->numbers.data(), n)
+                                       : ArrayKernels::min(array->numbers.data(), n));
+        }
+
+        TaggedValue result = array->get(0);
+
+        for(size_t i = 1; i < n; i++) {
+            if(Operations::compare(better, array->get(i), result, token)) {
+                result = array->get(i);
+            }
+        }
+        return result;
+    }
+
+    if(argc == 0) {
+        Builtins::argument_error(token, function + " expects an array or at least two numbers.");
+    }
+
+    TaggedValue result = args[0];
+
+    for(int i = 1; i < argc; i++) {
+        if(Operations::compare(better, args[i], result, token)) {
+            result = args[i];
+        }
+    }
+    return result;
+}
+
+TaggedValue Builtins::math() {
+    return make_library({
+        { "sqrt", 1, math_sqrt },
+        { "exp", 1, math_exp },
+        { "log", 1, math_log },
+        { "floor", 1, math_floor },
+        { "pow", 2, math_pow },
+        { "sum", 1, math_sum },
+        { "dot", 2, math_dot },
+        { "min", -1, extreme<false> },
+        { "max", -1, extreme<true> },
+    });
+}
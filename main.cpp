@@ -1,14 +1,92 @@
 #include <iostream>
 #include <string>
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
 #include "interpreter/Interpreter.h"
+#include "vm/VM.h"
+#include "interpreter/Heap.h"
+#include "interpreter/FramePool.h"
+#include "interpreter/ModuleRegistry.h"
+#include "interpreter/Profiler.h"
+#include "utils/Output.h"
+#include "parser/ASTPrinter.h"
+
+static void print_gc_stats() {
+    heap.print_stats(std::cerr);
+    frame_pool.print_stats(std::cerr);
+}
 
 int main(int argc, char** argv) {
-    std::string path = argv[1];
+    bool tree_walk = false;
+    bool dump_ast = false;
+    int jobs = std::max(1, (int) std::thread::hardware_concurrency());
+    std::string path;
+    std::string profile;
+    std::string counts;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if(arg == "--tree-walk") {
+            tree_walk = true;
+        } else if(arg == "--dump-ast") {
+            dump_ast = true;
+        } else if(arg == "--gc-stats") {
+            std::atexit(print_gc_stats);
+        } else if(arg.rfind("--jobs=", 0) == 0) {
+            jobs = std::max(1, std::stoi(arg.substr(7)));
+        } else if(arg.rfind("--max-depth=", 0) == 0) {
+            VM::max_depth = Interpreter::max_depth = std::stoul(arg.substr(12));
+        } else if(arg.rfind("--gc-young=", 0) == 0) {
+            heap.young_limit = std::stoul(arg.substr(11)) * 1024;
+        } else if(arg.rfind("--gc-old=", 0) == 0) {
+            heap.old_limit = std::stoul(arg.substr(9)) * 1024;
+        } else if(arg.rfind("--print-buffer=", 0) == 0) {
+            output.flush_size = std::stoul(arg.substr(15)) * 1024;
+        } else if(arg == "--line-buffered") {
+            output.line_buffered = true;
+        } else if(arg == "--profile") {
+            profile = "profile.folded";
+        } else if(arg.rfind("--profile=", 0) == 0) {
+            profile = arg.substr(10);
+        } else if(arg == "--count") {
+            counts = "counts.txt";
+        } else if(arg.rfind("--count=", 0) == 0) {
+            counts = arg.substr(8);
+        } else {
+            path = arg;
+        }
+    }
+
+    if(path.empty()) {
+        std::cout << "Usage: misty [--tree-walk] [--dump-ast] [--gc-stats] [--gc-young=<KB>] [--gc-old=<KB>] [--jobs=<n>] [--max-depth=<n>] [--print-buffer=<KB>] [--line-buffered] [--profile[=<stacks file>]] [--count[=<listing file>]] <file.mist>" << std::endl;
+        return 1;
+    }
+
+    module_registry.preload(path, jobs);
+
+    if(dump_ast) {
+        std::cout << ASTPrinter().print(module_registry.parse(path));
+        return 0;
+    }
 
-    Interpreter* interpreter = new Interpreter();
+    // Counts are kept on the tree, so counting always walks it.
+    if(!counts.empty()) {
+        profiler.start_counting(counts);
+        tree_walk = true;
+    } else if(!profile.empty()) {
+        profiler.start_sampling(profile);
+    }
 
-    interpreter->evaluate(path);
-    //std::cout << interpreter->memory_block->str();
+    if(tree_walk) {
+        Interpreter* interpreter = new Interpreter();
+        interpreter->evaluate(path);
+        //std::cout << interpreter->memory_block->str();
+    } else {
+        VM* vm = new VM();
+        vm->evaluate(path);
+    }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -1,118 +1,193 @@
 #include "AST.h"
 #include <iostream>
+#include <cstdlib>
 
 AST::~AST() = default;
 
-Value::Value(Token* token) {
+Value::Value(Token* token)
+: AST(NodeKind::VALUE) {
     this->token = token;
     this->value = token->value;
+    this->number = 0;
+    this->integer = 0;
+
+    // strtod saturates literals out of double range instead of throwing.
+    if(token->type_of(TokenType::FLOAT)) {
+        this->number = strtod(token->value.c_str(), NULL);
+    } else if(token->type_of(TokenType::INT)) {
+        this->integer = std::stoll(token->value);
+    }
 }
 
-BinaryOperator::BinaryOperator(AST* left, Token* op, AST* right) {
+BinaryOperator::BinaryOperator(AST* left, Token* op, AST* right)
+: AST(NodeKind::BINARY_OPERATOR) {
     this->token = op;
     this->op = op;
     this->left = left;
     this->right = right;
 }
 
-UnaryOperator::UnaryOperator(Token* op, AST* expr) {
+UnaryOperator::UnaryOperator(Token* op, AST* expr)
+: AST(NodeKind::UNARY_OPERATOR) {
     this->token = this->op = op;
     this->expr = expr;
 }
 
-Assign::Assign(AST* left, Token* op, AST* right) {
+Assign::Assign(AST* left, Token* op, AST* right)
+: AST(NodeKind::ASSIGN) {
     this->token = this->op = op;
     this->left = left;
     this->right = right;
 }
 
-Compare::Compare(std::vector<AST*> comparables, std::vector<Token*> operators) {
+Compare::Compare(std::vector<AST*> comparables, std::vector<Token*> operators)
+: AST(NodeKind::COMPARE) {
     this->comparables = comparables;
     this->operators = operators;
 }
 
-DoubleCondition::DoubleCondition(AST* left, Token* op, AST* right) {
+DoubleCondition::DoubleCondition(AST* left, Token* op, AST* right)
+: AST(NodeKind::DOUBLE_CONDITION) {
     this->token = this->op = op;
     this->left = left;
     this->right = right;
 }
 
-Variable::Variable(Token* token) {
+Variable::Variable(Token* token)
+: AST(NodeKind::VARIABLE) {
     this->token = token;
     this->value = token->value;
+    this->depth = -1;
+    this->slot = -1;
 }
 
-VariableDeclaration::VariableDeclaration(std::vector<Variable*> variables) {
+VariableDeclaration::VariableDeclaration(std::vector<Variable*> variables)
+: AST(NodeKind::VARIABLE_DECLARATION) {
     this->variables = variables;
 }
 
-Negation::Negation(Token* op, AST* statement) {
+Negation::Negation(Token* op, AST* statement)
+: AST(NodeKind::NEGATION) {
     this->token = this->op = op;
     this->statement = statement;
 }
 
-IfCondition::IfCondition(AST* condition, Compound* statement) {
+IfCondition::IfCondition(AST* condition, Compound* statement)
+: AST(NodeKind::IF_CONDITION) {
     this->condition = condition;
     this->statement = statement;
 }
 
-Print::Print(AST* printable) {
+Print::Print(AST* printable)
+: AST(NodeKind::PRINT) {
     this->printable = printable;
 }
 
-ArrayInit::ArrayInit(std::vector<AST*> elements) {
+ArrayInit::ArrayInit(Token* token, std::vector<AST*> elements)
+: AST(NodeKind::ARRAY_INIT) {
+    this->token = token;
     this->elements = elements;
 }
 
-ArrayAccess::ArrayAccess(AST* array, AST* index) {
+ArrayAccess::ArrayAccess(AST* array, AST* index)
+: AST(NodeKind::ARRAY_ACCESS) {
     this->array = array;
     this->index = index;
 }
 
-FunctionInit::FunctionInit(std::string func_name, VariableDeclaration* params, Compound* block) {
+MapInit::MapInit(Token* token, std::vector<AST*> keys, std::vector<AST*> values)
+: AST(NodeKind::MAP_INIT) {
+    this->token = token;
+    this->keys = keys;
+    this->values = values;
+}
+
+Delete::Delete(Token* token, ArrayAccess* target)
+: AST(NodeKind::DELETE) {
+    this->token = token;
+    this->target = target;
+}
+
+FunctionInit::FunctionInit(std::string func_name, VariableDeclaration* params, Compound* block)
+: FunctionInit(NodeKind::FUNCTION_INIT, func_name, params, block) {}
+
+FunctionInit::FunctionInit(NodeKind kind, std::string func_name, VariableDeclaration* params, Compound* block)
+: AST(kind) {
     this->func_name = func_name;
     this->params = params;
     this->block = block;
+    this->scope = NULL;
+    this->slot = -1;
+    this->arity = 0;
 }
 
-FunctionCall::FunctionCall(AST* function, std::vector<AST*> params) {
+FunctionCall::FunctionCall(AST* function, std::vector<AST*> params)
+: AST(NodeKind::FUNCTION_CALL) {
     this->function = function;
     this->params = params;
 }
 
-Return::Return(Token* token, AST* returnable) {
+Return::Return(Token* token, AST* returnable)
+: AST(NodeKind::RETURN) {
     this->token = token;
     this->returnable = returnable;
 }
 
-Compound::Compound(bool inside_func) {
+Compound::Compound(bool inside_func)
+: AST(NodeKind::COMPOUND) {
     this->inside_func = inside_func;
+    this->scope = NULL;
 }
 
-WhileLoop::WhileLoop(AST* condition, Compound* statement) {
+WhileLoop::WhileLoop(AST* condition, Compound* statement)
+: AST(NodeKind::WHILE_LOOP) {
     this->condition = condition;
     this->statement = statement;
 }
 
-ClassInit::ClassInit(std::string class_name, Compound* block) {
-    this->class_name = class_name;
-    this->block = block;
+ForLoop::ForLoop(Token* token, Variable* variable, AST* start, AST* end, AST* step, Compound* statement)
+: AST(NodeKind::FOR_LOOP) {
+    this->token = token;
+    this->variable = variable;
+    this->start = start;
+    this->end = end;
+    this->step = step;
+    this->statement = statement;
+    this->scope = NULL;
 }
 
-CastValue::CastValue(AST* value, Token* type) {
+ClassInit::ClassInit(std::string class_name, VariableDeclaration* params, Compound* block)
+: FunctionInit(NodeKind::CLASS_INIT, class_name, params, block) {}
+
+CastValue::CastValue(AST* value, Token* type)
+: AST(NodeKind::CAST_VALUE) {
     this->value = value;
     this->type = type;
     this->token = type;
 }
 
-Import::Import(Token* path, std::string name) {
+Import::Import(Token* path, std::string name)
+: AST(NodeKind::IMPORT) {
     this->path = path->value;
     this->name = name;
     this->token = path;
+    this->slot = -1;
 }
 
-ObjectDive::ObjectDive(AST* parent, Token* colon, Variable* child) {
+ObjectDive::ObjectDive(AST* parent, Token* colon, Variable* child)
+: AST(NodeKind::OBJECT_DIVE) {
     this->parent = parent;
     this->child = child;
+    this->cache = NULL;
     this->token = colon;
-}
\ No newline at end of file
+}
+
+Probe::Probe(AST* statement, Token* token)
+: AST(NodeKind::PROBE) {
+    this->statement = statement;
+    this->token = token;
+    this->function = NULL;
+    this->count = 0;
+    this->nanoseconds = 0;
+    this->active = 0;
+}
@@ -5,17 +5,60 @@
 #include <vector>
 #include <map>
 #include <cmath>
+#include <cstdint>
+
+class SymbolTable;
+class MemberCache;
+
+// Concrete type of an AST node, set by every constructor so visitors can
+// dispatch with a switch instead of a chain of dynamic_casts.
+enum class NodeKind {
+    VALUE,
+    BINARY_OPERATOR,
+    UNARY_OPERATOR,
+    COMPOUND,
+    VARIABLE,
+    ASSIGN,
+    VARIABLE_DECLARATION,
+    NO_OPERATOR,
+    COMPARE,
+    NEGATION,
+    DOUBLE_CONDITION,
+    IF_CONDITION,
+    PRINT,
+    ARRAY_INIT,
+    ARRAY_ACCESS,
+    MAP_INIT,
+    DELETE,
+    FUNCTION_INIT,
+    FUNCTION_CALL,
+    RETURN,
+    WHILE_LOOP,
+    FOR_LOOP,
+    CLASS_INIT,
+    CAST_VALUE,
+    IMPORT,
+    OBJECT_DIVE,
+    PROBE
+};
 
 class AST {
     public:
+        NodeKind kind;
         Token* token = NULL;
 
+        AST(NodeKind kind) {
+            this->kind = kind;
+        }
+
         virtual ~AST() = 0;
 };
 
 class Value : public AST {
     public:
         std::string value;
+        double number;
+        int64_t integer;
 
         Value(Token* token);
         ~Value() override {};
@@ -47,6 +90,10 @@ class Compound : public AST {
         std::vector<AST*> children;
         bool inside_func;
 
+        // Set by the SemanticAnalyzer when the block declares names and
+        // therefore gets its own Memory at runtime, NULL otherwise.
+        SymbolTable* scope;
+
         Compound(bool inside_func);
         ~Compound() override {};
 
@@ -56,6 +103,11 @@ class Variable : public AST {
     public:
         std::string value;
 
+        // Resolved by the SemanticAnalyzer: number of enclosing Memory
+        // blocks to walk up, and the slot inside the block found there.
+        int depth;
+        int slot;
+
         Variable(Token* token);
         ~Variable() override {};
 };
@@ -79,7 +131,12 @@ class VariableDeclaration : public AST {
         ~VariableDeclaration() override {};
 };
 
-class NoOperator : public AST {};
+class NoOperator : public AST {
+    public:
+        NoOperator()
+        : AST(NodeKind::NO_OPERATOR) {}
+        ~NoOperator() override {};
+};
 
 class Compare : public AST {
     public:
@@ -136,7 +193,7 @@ class ArrayInit : public AST {
     public:
         std::vector<AST*> elements;
 
-        ArrayInit(std::vector<AST*> elements);
+        ArrayInit(Token* token, std::vector<AST*> elements);
         ~ArrayInit() override {};
 };
 
@@ -149,13 +206,40 @@ class ArrayAccess : public AST {
         ~ArrayAccess() override {};
 };
 
+class MapInit : public AST {
+    public:
+        // keys[i] maps to values[i].
+        std::vector<AST*> keys;
+        std::vector<AST*> values;
+
+        MapInit(Token* token, std::vector<AST*> keys, std::vector<AST*> values);
+        ~MapInit() override {};
+};
+
+// `delete map[key];`
+class Delete : public AST {
+    public:
+        ArrayAccess* target;
+
+        Delete(Token* token, ArrayAccess* target);
+        ~Delete() override {};
+};
+
 class FunctionInit : public AST {
     public:
         std::string func_name;
         VariableDeclaration* params;
         Compound* block;
 
+        SymbolTable* scope;
+        int slot;
+
+        // Parameters are the first symbols defined in scope, so arguments
+        // bind straight into slots 0 to arity - 1 of the callee's Memory.
+        int arity;
+
         FunctionInit(std::string func_name, VariableDeclaration* params, Compound* block);
+        FunctionInit(NodeKind kind, std::string func_name, VariableDeclaration* params, Compound* block);
         ~FunctionInit() override {};
 };
 
@@ -185,12 +269,35 @@ class WhileLoop : public AST {
         ~WhileLoop() override {};
 };
 
-class ClassInit : public AST {
+// `for(variable in start to end by step)` counts variable from start up to,
+// but not including, end (down to, for a negative step); the step defaults
+// to 1. `for(variable in collection)` visits the elements of an array or
+// the keys of a map. end is NULL for the second form.
+class ForLoop : public AST {
     public:
-        std::string class_name;
-        Compound* block;
+        Variable* variable;
+        AST* start;
+        AST* end;
+        AST* step;
+        Compound* statement;
+
+        // Set by the SemanticAnalyzer. The loop's own scope: variable in
+        // slot 0, then the bound (end, or the collection) and the step (or
+        // the position in the collection), each evaluated once.
+        SymbolTable* scope;
+
+        ForLoop(Token* token, Variable* variable, AST* start, AST* end, AST* step, Compound* statement);
+        ~ForLoop() override {};
+};
 
-        ClassInit(std::string class_name, Compound* block);
+// A class is called like a function whose scope becomes the new instance:
+// the body runs once per instance, and its names (parameters, fields and
+// methods, which close over the instance) are the instance's members.
+// Every instance has scope as its shape, so a member sits in the same slot
+// of each one and a MemberCache reads it with a single indexed load.
+class ClassInit : public FunctionInit {
+    public:
+        ClassInit(std::string class_name, VariableDeclaration* params, Compound* block);
         ~ClassInit() override {};
 };
 
@@ -208,6 +315,8 @@ class Import : public AST {
         std::string path;
         std::string name;
 
+        int slot;
+
         Import(Token* path, std::string name);
         ~Import() override {};
 };
@@ -217,8 +326,32 @@ class ObjectDive : public AST {
         AST* parent;
         Variable* child;
 
+        // Set by the SemanticAnalyzer; shared by both execution modes.
+        MemberCache* cache;
+
         ObjectDive(AST* parent, Token* colon, Variable* child);
         ~ObjectDive() override {};
 };
 
+// Wraps a statement, condition or function body that the tree-walking
+// Interpreter reports on as it runs. Never made by the Parser; see
+// Profiler::instrument.
+class Probe : public AST {
+    public:
+        AST* statement;
+
+        // Set when statement is the body of function.
+        FunctionInit* function;
+
+        // Runs of statement and the time they took, when counting. Only
+        // the outermost of recursive runs adds its time; active is the
+        // number in progress.
+        uint64_t count;
+        uint64_t nanoseconds;
+        uint32_t active;
+
+        Probe(AST* statement, Token* token);
+        ~Probe() override {};
+};
+
 #endif
\ No newline at end of file
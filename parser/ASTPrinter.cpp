@@ -0,0 +1,247 @@
+#include "ASTPrinter.h"
+
+std::string ASTPrinter::print(AST* node) {
+    output.clear();
+    print(node, 0);
+    return output;
+}
+
+void ASTPrinter::line(int indent, std::string text) {
+    output += std::string(indent * 2, ' ') + text + "\n";
+}
+
+void ASTPrinter::print(AST* node, int indent) {
+    switch(node->kind) {
+        case NodeKind::VALUE:
+        {
+            Value* val = (Value*) node;
+
+            if(val->token->type_of(TokenType::STRING)) {
+                line(indent, "Value '" + val->value + "'");
+            } else {
+                line(indent, "Value " + val->value);
+            }
+            break;
+        }
+        case NodeKind::BINARY_OPERATOR:
+        {
+            BinaryOperator* op = (BinaryOperator*) node;
+            line(indent, "BinaryOperator " + op->op->value);
+            print(op->left, indent + 1);
+            print(op->right, indent + 1);
+            break;
+        }
+        case NodeKind::UNARY_OPERATOR:
+        {
+            UnaryOperator* op = (UnaryOperator*) node;
+            line(indent, "UnaryOperator " + op->op->value);
+            print(op->expr, indent + 1);
+            break;
+        }
+        case NodeKind::COMPOUND:
+        {
+            line(indent, "Compound");
+
+            for(AST* child : ((Compound*) node)->children) {
+                print(child, indent + 1);
+            }
+            break;
+        }
+        case NodeKind::VARIABLE:
+            line(indent, "Variable " + ((Variable*) node)->value);
+            break;
+
+        case NodeKind::ASSIGN:
+        {
+            Assign* assign = (Assign*) node;
+            line(indent, "Assign");
+            print(assign->left, indent + 1);
+            print(assign->right, indent + 1);
+            break;
+        }
+        case NodeKind::VARIABLE_DECLARATION:
+        {
+            VariableDeclaration* decl = (VariableDeclaration*) node;
+            line(indent, "VariableDeclaration");
+
+            for(size_t i = 0; i < decl->variables.size(); i++) {
+                print(decl->variables[i], indent + 1);
+
+                if(i < decl->assignments.size()) {
+                    print(decl->assignments[i]->right, indent + 2);
+                }
+            }
+            break;
+        }
+        case NodeKind::NO_OPERATOR:
+            line(indent, "NoOperator");
+            break;
+
+        case NodeKind::COMPARE:
+        {
+            Compare* c = (Compare*) node;
+            std::string operators;
+
+            for(Token* op : c->operators) {
+                operators += " " + op->value;
+            }
+
+            line(indent, "Compare" + operators);
+
+            for(AST* comparable : c->comparables) {
+                print(comparable, indent + 1);
+            }
+            break;
+        }
+        case NodeKind::NEGATION:
+            line(indent, "Negation");
+            print(((Negation*) node)->statement, indent + 1);
+            break;
+
+        case NodeKind::DOUBLE_CONDITION:
+        {
+            DoubleCondition* cond = (DoubleCondition*) node;
+            line(indent, "DoubleCondition " + cond->op->value);
+            print(cond->left, indent + 1);
+            print(cond->right, indent + 1);
+            break;
+        }
+        case NodeKind::IF_CONDITION:
+        {
+            IfCondition* cond = (IfCondition*) node;
+            std::vector<IfCondition*> branches = { cond };
+            branches.insert(branches.end(), cond->elses.begin(), cond->elses.end());
+
+            line(indent, "IfCondition");
+
+            for(IfCondition* branch : branches) {
+                if(branch->condition == NULL) {
+                    line(indent + 1, "Always");
+                } else {
+                    line(indent + 1, "When");
+                    print(branch->condition, indent + 2);
+                }
+                print(branch->statement, indent + 2);
+            }
+            break;
+        }
+        case NodeKind::PRINT:
+            line(indent, "Print");
+            print(((Print*) node)->printable, indent + 1);
+            break;
+
+        case NodeKind::ARRAY_INIT:
+        {
+            line(indent, "ArrayInit");
+
+            for(AST* element : ((ArrayInit*) node)->elements) {
+                print(element, indent + 1);
+            }
+            break;
+        }
+        case NodeKind::ARRAY_ACCESS:
+        {
+            ArrayAccess* access = (ArrayAccess*) node;
+            line(indent, "ArrayAccess");
+            print(access->array, indent + 1);
+            print(access->index, indent + 1);
+            break;
+        }
+        case NodeKind::MAP_INIT:
+        {
+            MapInit* map_init = (MapInit*) node;
+            line(indent, "MapInit");
+
+            for(size_t i = 0; i < map_init->keys.size(); i++) {
+                line(indent + 1, "Pair");
+                print(map_init->keys[i], indent + 2);
+                print(map_init->values[i], indent + 2);
+            }
+            break;
+        }
+        case NodeKind::DELETE:
+            line(indent, "Delete");
+            print(((Delete*) node)->target, indent + 1);
+            break;
+
+        case NodeKind::FUNCTION_INIT:
+        case NodeKind::CLASS_INIT:
+        {
+            FunctionInit* func_init = (FunctionInit*) node;
+            std::string params;
+
+            if(func_init->params != NULL) {
+                for(Variable* param : func_init->params->variables) {
+                    params += (params.empty() ? "" : ", ") + param->value;
+                }
+            }
+
+            std::string kind = node->kind == NodeKind::CLASS_INIT ? "ClassInit " : "FunctionInit ";
+            line(indent, kind + func_init->func_name + "(" + params + ")");
+            print(func_init->block, indent + 1);
+            break;
+        }
+        case NodeKind::FUNCTION_CALL:
+        {
+            FunctionCall* call = (FunctionCall*) node;
+            line(indent, "FunctionCall");
+            print(call->function, indent + 1);
+
+            for(AST* param : call->params) {
+                print(param, indent + 2);
+            }
+            break;
+        }
+        case NodeKind::RETURN:
+            line(indent, "Return");
+            print(((Return*) node)->returnable, indent + 1);
+            break;
+
+        case NodeKind::WHILE_LOOP:
+        {
+            WhileLoop* while_loop = (WhileLoop*) node;
+            line(indent, "WhileLoop");
+            print(while_loop->condition, indent + 1);
+            print(while_loop->statement, indent + 1);
+            break;
+        }
+        case NodeKind::FOR_LOOP:
+        {
+            ForLoop* for_loop = (ForLoop*) node;
+            line(indent, "ForLoop " + for_loop->variable->value);
+            print(for_loop->start, indent + 1);
+
+            if(for_loop->end != NULL) {
+                print(for_loop->end, indent + 1);
+            }
+
+            if(for_loop->step != NULL) {
+                print(for_loop->step, indent + 1);
+            }
+            print(for_loop->statement, indent + 1);
+            break;
+        }
+        case NodeKind::CAST_VALUE:
+        {
+            CastValue* cast = (CastValue*) node;
+            line(indent, "CastValue " + cast->type->value);
+            print(cast->value, indent + 1);
+            break;
+        }
+        case NodeKind::IMPORT:
+        {
+            Import* import = (Import*) node;
+            line(indent, "Import '" + import->path + "' as " + import->name);
+            break;
+        }
+        case NodeKind::OBJECT_DIVE:
+        {
+            ObjectDive* dive = (ObjectDive*) node;
+            line(indent, "ObjectDive " + dive->child->value);
+            print(dive->parent, indent + 1);
+            break;
+        }
+        default:
+            line(indent, "Unknown");
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef AST_PRINTER_H
+#define AST_PRINTER_H
+
+#include <string>
+#include "AST.h"
+
+// Renders a tree as one node per line, children indented below their
+// parent. Used by --dump-ast to inspect what the Optimizer produced.
+class ASTPrinter {
+    public:
+        std::string print(AST* node);
+
+    private:
+        std::string output;
+
+        void print(AST* node, int indent);
+        void line(int indent, std::string text);
+};
+
+#endif
@@ -129,20 +129,34 @@ ObjectDive* Parser::object_dive(AST* parent) {
     return dive;
 }
 
-AST* Parser::identifier_statement() {
-    AST* left = variable();
-    Token* token = current_token;
+// Index, call and member suffixes in any order, as in mod:f(x)[0].
+AST* Parser::postfix(AST* node) {
+    for(;;) {
+        if(current_token->type_of(TokenType::L_SQUARED)) {
+            node = array_access(node);
+
+        } else if(current_token->type_of(TokenType::L_PAREN)) {
+            node = function_call(node);
 
-    if(token->type_of(TokenType::L_PAREN)) {
-        return function_call(left);
+        } else if(current_token->type_of(TokenType::COLON)) {
+            node = object_dive(node);
+
+        } else {
+            return node;
+        }
     }
+}
+
+AST* Parser::identifier_statement() {
+    AST* left = postfix(variable());
+    Token* token = current_token;
 
-    if(token->type_of(TokenType::L_SQUARED)) {
-        left = array_access(left);
+    if(left->kind == NodeKind::FUNCTION_CALL) {
+        return left;
     }
 
-    if(token->type_of(TokenType::COLON)) {
-        return object_dive(left);
+    if(left->kind == NodeKind::OBJECT_DIVE && !token->type_of(TokenType::ASSIGN)) {
+        return left;
     }
 
     eat(TokenType::ASSIGN);
@@ -171,6 +185,36 @@ IfCondition* Parser::else_statement() {
 
         return new IfCondition(condition, compound_statement());
     }
+
+    error(current_token);
+    return NULL;
+}
+
+ForLoop* Parser::for_loop_statement() {
+    Token* token = current_token;
+    eat(TokenType::FOR);
+    eat(TokenType::L_PAREN);
+
+    Variable* variable = this->variable();
+    eat(TokenType::IN);
+
+    AST* start = expr();
+    AST* end = NULL;
+    AST* step = NULL;
+
+    if(current_token->type_of(TokenType::TO)) {
+        eat(TokenType::TO);
+        end = expr();
+
+        if(current_token->type_of(TokenType::BY)) {
+            eat(TokenType::BY);
+            step = expr();
+        }
+    }
+    eat(TokenType::R_PAREN);
+
+    Compound* statement = compound_statement();
+    return new ForLoop(token, variable, start, end, step, statement);
 }
 
 WhileLoop* Parser::while_loop_statement() {
@@ -192,6 +236,31 @@ Print* Parser::print_statement() {
     return new Print(printable);
 }
 
+// `class Name(params) { ... }`; the parameter list may be left out.
+ClassInit* Parser::class_init_statement() {
+    eat(TokenType::CLASS);
+    std::string class_name = current_token->value;
+    eat(TokenType::IDENTIFIER);
+
+    VariableDeclaration* params = NULL;
+
+    if(current_token->type_of(TokenType::L_PAREN)) {
+        eat(TokenType::L_PAREN);
+
+        if(current_token->type_of(TokenType::IDENTIFIER)) {
+            params = standard_variable_declaration();
+        }
+        eat(TokenType::R_PAREN);
+    }
+
+    bool enclosing = inside_func;
+    inside_func = true;
+    Compound* block = compound_statement();
+    inside_func = enclosing;
+
+    return new ClassInit(class_name, params, block);
+}
+
 FunctionInit* Parser::function_init_statement() {
     eat(TokenType::FUNCTION);
     std::string func_name = current_token->value;
@@ -259,7 +328,23 @@ Import* Parser::import_statement() {
     std::string name = current_token->value;
     eat(TokenType::IDENTIFIER);
 
-    return new Import(path, name);
+    Import* import = new Import(path, name);
+    imports.push_back(import);
+
+    return import;
+}
+
+Delete* Parser::delete_statement() {
+    Token* token = current_token;
+    eat(TokenType::DELETE);
+
+    AST* target = postfix(variable());
+
+    if(target->kind != NodeKind::ARRAY_ACCESS) {
+        error(token);
+    }
+
+    return new Delete(token, (ArrayAccess*) target);
 }
 
 AST* Parser::statement() {
@@ -291,6 +376,10 @@ AST* Parser::statement() {
             node = while_loop_statement();
             break;
 
+        case TokenType::FOR:
+            node = for_loop_statement();
+            break;
+
         case TokenType::PRINT:
             node = print_statement();
             break;
@@ -299,6 +388,10 @@ AST* Parser::statement() {
             node = function_init_statement();
             break;
 
+        case TokenType::CLASS:
+            node = class_init_statement();
+            break;
+
         case TokenType::RETURN:
             node = return_statement();
             break;
@@ -307,6 +400,10 @@ AST* Parser::statement() {
             node = import_statement();
             break;
 
+        case TokenType::DELETE:
+            node = delete_statement();
+            break;
+
         default:
             node = empty();
     }
@@ -332,10 +429,34 @@ ArrayAccess* Parser::array_access(AST* array) {
 }
 
 ArrayInit* Parser::array_init() {
+    Token* token = current_token;
     eat(TokenType::L_SQUARED);
     std::vector<AST*> elements = collection(TokenType::R_SQUARED);
 
-    return new ArrayInit(elements);
+    return new ArrayInit(token, elements);
+}
+
+// `{key = value, ...}`. A colon would read as member access after a
+// variable key, so pairs are written with `=`.
+MapInit* Parser::map_init() {
+    Token* token = current_token;
+    eat(TokenType::L_CURLY);
+
+    std::vector<AST*> keys;
+    std::vector<AST*> values;
+
+    while(!current_token->type_of(TokenType::R_CURLY)) {
+        if(!keys.empty()) {
+            eat(TokenType::COMMA);
+        }
+
+        keys.push_back(expr());
+        eat(TokenType::ASSIGN);
+        values.push_back(expr());
+    }
+    eat(TokenType::R_CURLY);
+
+    return new MapInit(token, keys, values);
 }
 
 AST* Parser::factor() {
@@ -361,6 +482,12 @@ AST* Parser::factor() {
             return new Value(token);
         }
 
+        case TokenType::INT:
+        {
+            eat(TokenType::INT);
+            return new Value(token);
+        }
+
         case TokenType::NOT:
         {
             eat(TokenType::NOT);
@@ -391,26 +518,13 @@ AST* Parser::factor() {
             return node;
         }
         case TokenType::L_SQUARED:
-        {
-            AST* node = array_init();
-            if(current_token->type_of(TokenType::L_SQUARED)) {
-                node = array_access(node);
-            }
-            return node;
-        }
+            return postfix(array_init());
+
+        case TokenType::L_CURLY:
+            return postfix(map_init());
         
         default:
-            AST* node = variable();
-            if(current_token->type_of(TokenType::L_SQUARED)) {
-                node = array_access(node);
-
-            } else if(current_token->type_of(TokenType::L_PAREN)) {
-                node = function_call(node);
-
-            } else if(current_token->type_of(TokenType::COLON)) {
-                node = object_dive(node);
-            }
-            return node;
+            return postfix(variable());
     }
     
 }
@@ -489,7 +603,7 @@ AST* Parser::eq_not_eq() {
             Token* op = current_token;
             eat(current_token->type);
 
-            comparables.push_back(expr());
+            comparables.push_back(sub_add());
             operators.push_back(op);
         }
         node = new Compare(comparables, operators);
@@ -12,6 +12,8 @@ class Parser {
     public:
         Parser(Lexer* lexer);
         AST* parse();
+
+        std::vector<Import*> imports;
     
     private:
         Lexer* lexer;
@@ -34,6 +36,7 @@ class Parser {
         NoOperator* empty();
 
         AST* identifier_statement();
+        AST* postfix(AST* node);
         AST* statement();
         std::vector<AST*> statement_list();
 
@@ -42,17 +45,21 @@ class Parser {
         IfCondition* if_statement();
         IfCondition* else_statement();
         WhileLoop* while_loop_statement();
+        ForLoop* for_loop_statement();
         Compound* compound_statement();
         Print* print_statement();
         Return* return_statement();
         Import* import_statement();
+        Delete* delete_statement();
 
         ArrayInit* array_init();
+        MapInit* map_init();
         ArrayAccess* array_access(AST* array);
 
         ObjectDive* object_dive(AST* parent);
 
         FunctionInit* function_init_statement();
+        ClassInit* class_init_statement();
         FunctionCall* function_call(AST* function);
 
         void error(Token* token);
@@ -4,6 +4,7 @@
 #include <string>
 #include <iostream>
 #include "../lexer/Token.h"
+#include "Output.h"
 
 class Error {
     public:
@@ -13,6 +14,11 @@ class Error {
 
         int line, column;
 
+        // Set on threads that parse modules ahead of execution. The error is
+        // thrown back to the caller instead of ending the process, so it can
+        // be reported when execution actually reaches the import.
+        inline static thread_local bool deferred = false;
+
         Error(std::string error_type, std::string file_path, int line, int column, std::string message) {
             this->error_type = error_type;
             this->file_path = file_path;
@@ -30,6 +36,11 @@ class Error {
         }
 
         void cast() {
+            if(deferred) {
+                throw *this;
+            }
+
+            output.flush();
             std::cout << error_type << "In file: " << file_path << " line " << line << ", column " << column << ": " << error_message << std::endl;
             exit(0);
         }
@@ -53,4 +64,22 @@ class ValueError : public Error {
         : Error("ValueError: ", file_path, line, column, message) {}
 };
 
+class ImportError : public Error {
+    public:
+        ImportError(std::string file_path, int line, int column, std::string message) 
+        : Error("ImportError: ", file_path, line, column, message) {}
+};
+
+class IOError : public Error {
+    public:
+        IOError(std::string file_path, int line, int column, std::string message) 
+        : Error("IOError: ", file_path, line, column, message) {}
+};
+
+class RecursionError : public Error {
+    public:
+        RecursionError(std::string file_path, int line, int column, std::string message) 
+        : Error("RecursionError: ", file_path, line, column, message) {}
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <string>
+#include <cstdio>
+
+// Where print writes. Values are formatted straight into one buffer that is
+// kept between prints and handed to stdout in a single write once it holds
+// flush_size bytes, before an error is reported, and at exit. With
+// line_buffered set every line is written as soon as it is complete, for
+// watching a program as it runs.
+class Output {
+    public:
+        std::string buffer;
+        size_t flush_size;
+        bool line_buffered;
+
+        Output() {
+            this->flush_size = 64 * 1024;
+            this->line_buffered = false;
+        }
+
+        ~Output() {
+            flush();
+        }
+
+        // Ends the line written into buffer.
+        void end_line() {
+            buffer += '\n';
+
+            if(line_buffered || buffer.size() >= flush_size) {
+                flush();
+            }
+        }
+
+        void flush() {
+            if(!buffer.empty()) {
+                fwrite(buffer.data(), 1, buffer.size(), stdout);
+                buffer.clear();
+            }
+            fflush(stdout);
+        }
+};
+
+inline Output output;
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef PATH_H
+#define PATH_H
+
+#include <string>
+#include <filesystem>
+
+inline std::string get_dir_from_path(std::string path) {
+    std::string directory;
+    const size_t last_slash_index = path.find_last_of("\\/");
+    if (std::string::npos != last_slash_index) {
+        directory = path.substr(0, last_slash_index + 1);
+    }
+    return directory;
+}
+
+// Absolute path with `.`, `..` and symlinks resolved, used to identify a
+// module no matter how an import spelled it. Missing files are returned
+// unresolved.
+inline std::string get_canonical_path(std::string path) {
+    std::error_code error;
+    std::filesystem::path canonical = std::filesystem::canonical(path, error);
+
+    if(error) {
+        return path;
+    }
+    return canonical.string();
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef STACK_TRACE_H
+#define STACK_TRACE_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include "../lexer/Token.h"
+
+// The Misty calls active when an error was raised, innermost first. Very
+// deep stacks only show their innermost and outermost calls.
+class StackTrace {
+    public:
+        static const int shown = 10;
+
+        void add(std::string function, Token* call) {
+            calls.push_back({ function, call });
+        }
+
+        std::string str() {
+            std::string trace = "Stack trace (most recent call first):";
+
+            for(size_t i = 0; i < calls.size(); i++) {
+                if(i == shown && calls.size() > 2 * shown) {
+                    trace += "\n    ... " + std::to_string(calls.size() - 2 * shown) + " more calls ...";
+                    i = calls.size() - shown;
+                }
+
+                Token* call = calls[i].second;
+                trace += "\n    " + calls[i].first + " called from " + call->file +
+                         " line " + std::to_string(call->line) + ", column " + std::to_string(call->column);
+            }
+            return trace;
+        }
+
+    private:
+        std::vector<std::pair<std::string, Token*>> calls;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Fixed set of worker threads draining a shared task queue. Tasks may
+// submit further tasks; wait() returns once the queue is empty and no
+// task is running.
+class ThreadPool {
+    public:
+        ThreadPool(int threads) {
+            this->pending = 0;
+            this->stopping = false;
+
+            for(int i = 0; i < threads; i++) {
+                workers.push_back(std::thread(&ThreadPool::work, this));
+            }
+        }
+
+        ~ThreadPool() {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            available.notify_all();
+
+            for(std::thread& worker : workers) {
+                worker.join();
+            }
+        }
+
+        void submit(std::function<void()> task) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                tasks.push(task);
+                pending++;
+            }
+            available.notify_one();
+        }
+
+        void wait() {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this] { return pending == 0; });
+        }
+
+    private:
+        std::vector<std::thread> workers;
+        std::queue<std::function<void()>> tasks;
+
+        std::mutex mutex;
+        std::condition_variable available;
+        std::condition_variable done;
+
+        int pending;
+        bool stopping;
+
+        void work() {
+            for(;;) {
+                std::function<void()> task;
+
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    available.wait(lock, [this] { return stopping || !tasks.empty(); });
+
+                    if(tasks.empty()) {
+                        return;
+                    }
+
+                    task = tasks.front();
+                    tasks.pop();
+                }
+
+                task();
+
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    pending--;
+                }
+                done.notify_all();
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,660 @@
+#include <iostream>
+#include "VM.h"
+#include "../utils/Output.h"
+
+VM::VM() {
+    memory_block = NULL;
+    module_name = NULL;
+
+    heap.add_roots(this);
+}
+
+VM::~VM() {
+    heap.remove_roots(this);
+}
+
+void VM::trace_roots(Heap* heap) {
+    for(TaggedValue& value : stack) {
+        heap->mark(value);
+    }
+
+    for(CallFrame& frame : frames) {
+        heap->mark_chain(frame.caller_block);
+    }
+    heap->mark_chain(memory_block);
+}
+
+void VM::name_error(Token* token) {
+    std::string message = "Variable has not been initialized.";
+    NameError(token->file, token->line, token->column, message).cast();
+}
+
+void VM::call_error(Token* token, std::string message) {
+    SyntaxError(token->file, token->line, token->column, message).cast();
+}
+
+Function* VM::callee(int argc, Token* token) {
+    TaggedValue callee = stack[stack.size() - argc - 1];
+
+    if(callee.type != Type::FUNCTION) {
+        call_error(token, "Given object is not a function.");
+    }
+
+    Function* function = (Function*) callee.ref;
+    int arity = function->func->arity;
+
+    if(arity == 0 && argc > 0) {
+        call_error(token, "Function " + function->func->func_name + " has no arguments, but " +
+                          std::to_string(argc) + " were given.");
+
+    } else if(arity != argc) {
+        call_error(token, "Inconsistent number of arguments.");
+    }
+
+    return function;
+}
+
+Memory* VM::bind_arguments(Function* function, int argc) {
+    Memory* block = frame_pool.enter(function->func->scope, function->closure);
+
+    for(int i = 0; i < argc; i++) {
+        block->slots[i] = stack[stack.size() - argc + i];
+    }
+    stack.resize(stack.size() - argc - 1);
+
+    return block;
+}
+
+bool VM::call_native(int argc, Token* token) {
+    size_t base = stack.size() - argc;
+    TaggedValue callee = stack[base - 1];
+
+    if(callee.type != Type::NATIVE) {
+        return false;
+    }
+
+    NativeFunction* native = (NativeFunction*) callee.ref;
+
+    if(!native->accepts(argc)) {
+        call_error(token, "Inconsistent number of arguments.");
+    }
+
+    stack[base - 1] = native->code(stack.data() + base, argc, token);
+    stack.resize(base);
+    return true;
+}
+
+void VM::recursion_error(Function* function, Token* token, Chunk* chunk) {
+    StackTrace trace;
+    trace.add(function->func->func_name, token);
+
+    // Each frame holds the return address into its caller; the function it
+    // called is whatever the next frame (or the current chunk) is running.
+    for(int i = frames.size() - 1; i >= 0; i--) {
+        Chunk* callee = i + 1 < (int) frames.size() ? frames[i + 1].chunk : chunk;
+        Chunk* caller = frames[i].chunk;
+
+        trace.add(callee->name, caller->tokens[frames[i].ip - 1 - caller->code.data()]);
+    }
+
+    std::string message = "Maximum recursion depth of " + std::to_string(max_depth) + " exceeded.\n" + trace.str();
+    RecursionError(token->file, token->line, token->column, message).cast();
+}
+
+TaggedValue VM::import_module(Token* path) {
+    if(path->type_of(TokenType::BUILT_IN_LIB)) {
+        return module_registry.builtin(path);
+    }
+
+    std::string module_path = directory + path->value;
+    TaggedValue module = module_registry.find(get_canonical_path(module_path), path);
+
+    if(module.is_empty()) {
+        module = VM().evaluate(module_path);
+    }
+    return module;
+}
+
+// Comparison fast path for two INTs or two FLOATs.
+template<typename Number>
+static bool compare_numbers(OpCode op, Number x, Number y) {
+    switch(op) {
+        case OpCode::EQUALS:
+            return x == y;
+        case OpCode::NOT_EQUALS:
+            return x != y;
+        case OpCode::LESS:
+            return x < y;
+        case OpCode::LESS_OR_EQ:
+            return x <= y;
+        case OpCode::MORE:
+            return x > y;
+        default:
+            return x >= y;
+    }
+}
+
+// Records a sample for the instruction at token. frames[0] was pushed by
+// the module's first call, and each frame holds its caller's chunk, so the
+// callees are frames[1] onwards and then chunk.
+void VM::sample(Chunk* chunk, Token* token) {
+    profiler.stack.assign(1, module_name);
+
+    for(size_t i = 1; i < frames.size(); i++) {
+        profiler.stack.push_back(&frames[i].chunk->name);
+    }
+
+    if(!frames.empty()) {
+        profiler.stack.push_back(&chunk->name);
+    }
+    profiler.sample(token);
+}
+
+template<bool profiling>
+TaggedValue VM::run(Chunk* entry) {
+    Chunk* chunk = entry;
+    Instruction* code = chunk->code.data();
+    Instruction* ip = code;
+
+    // The instruction that ran last, which a pending sample belongs to.
+    Token* executed = NULL;
+
+    for(;;) {
+        Instruction* ins = ip++;
+
+        if constexpr(profiling) {
+            if(Profiler::tick && executed != NULL) {
+                sample(chunk, executed);
+            }
+            executed = chunk->tokens[ins - code];
+        }
+
+        switch(ins->op) {
+            case OpCode::CONSTANT:
+                stack.push_back(chunk->constants[ins->arg]);
+                break;
+
+            case OpCode::NONE:
+                stack.push_back(TaggedValue::none());
+                break;
+
+            case OpCode::POP:
+                stack.pop_back();
+                break;
+
+            case OpCode::LOAD_LOCAL:
+            {
+                TaggedValue value = memory_block->slots[ins->arg];
+
+                if(value.is_empty()) {
+                    name_error(chunk->tokens[ins - code]);
+                }
+                stack.push_back(value);
+                break;
+            }
+            case OpCode::LOAD_VAR:
+            {
+                TaggedValue value = memory_block->up(ins->depth)->slots[ins->arg];
+
+                if(value.is_empty()) {
+                    name_error(chunk->tokens[ins - code]);
+                }
+                stack.push_back(value);
+                break;
+            }
+            case OpCode::STORE_LOCAL:
+                memory_block->slots[ins->arg] = stack.back();
+                stack.pop_back();
+                break;
+
+            case OpCode::STORE_VAR:
+            {
+                Memory* memory = memory_block->up(ins->depth);
+
+                memory->slots[ins->arg] = stack.back();
+                stack.pop_back();
+                heap.write_barrier(memory);
+                break;
+            }
+
+            case OpCode::ADD:
+            case OpCode::SUB:
+            case OpCode::MULT:
+            case OpCode::DIV:
+            case OpCode::INT_DIV:
+            case OpCode::MODULO:
+            {
+                TaggedValue right = stack.back();
+                stack.pop_back();
+                TaggedValue& left = stack.back();
+
+                if(left.type == Type::INT && right.type == Type::INT) {
+                    int64_t result;
+
+                    switch(ins->op) {
+                        case OpCode::ADD:
+                            if(!__builtin_add_overflow(left.integer, right.integer, &result)) {
+                                left.integer = result;
+                                continue;
+                            }
+                            break;
+                        case OpCode::SUB:
+                            if(!__builtin_sub_overflow(left.integer, right.integer, &result)) {
+                                left.integer = result;
+                                continue;
+                            }
+                            break;
+                        case OpCode::MULT:
+                            if(!__builtin_mul_overflow(left.integer, right.integer, &result)) {
+                                left.integer = result;
+                                continue;
+                            }
+                            break;
+                        default:
+                            break;
+                    }
+                }
+
+                if(left.type == Type::FLOAT && right.type == Type::FLOAT) {
+                    switch(ins->op) {
+                        case OpCode::ADD:
+                            left.number += right.number;
+                            continue;
+                        case OpCode::SUB:
+                            left.number -= right.number;
+                            continue;
+                        case OpCode::MULT:
+                            left.number *= right.number;
+                            continue;
+                        case OpCode::DIV:
+                            left.number /= right.number;
+                            continue;
+                        default:
+                            break;
+                    }
+                }
+
+                static const TokenType operators[] = {
+                    TokenType::PLUS, TokenType::MINUS, TokenType::MULT,
+                    TokenType::DIV, TokenType::INT_DIV, TokenType::MODULO
+                };
+                TokenType op = operators[(int) ins->op - (int) OpCode::ADD];
+                Token* token = chunk->tokens[ins - code];
+
+                left = Operations::binary_op(op, left, right, token, token);
+                break;
+            }
+            case OpCode::MINUS:
+                stack.back() = Operations::unary_minus(stack.back(), chunk->tokens[ins - code]);
+                break;
+
+            case OpCode::NOT:
+                stack.back() = Operations::negate(stack.back(), chunk->tokens[ins - code]);
+                break;
+
+            case OpCode::EQUALS:
+            case OpCode::NOT_EQUALS:
+            case OpCode::LESS:
+            case OpCode::LESS_OR_EQ:
+            case OpCode::MORE:
+            case OpCode::MORE_OR_EQ:
+            {
+                TaggedValue right = stack.back();
+                stack.pop_back();
+                TaggedValue& left = stack.back();
+
+                bool ints = left.type == Type::INT && right.type == Type::INT;
+
+                if(ints || (left.type == Type::FLOAT && right.type == Type::FLOAT)) {
+                    bool result = ints ? compare_numbers(ins->op, left.integer, right.integer)
+                                       : compare_numbers(ins->op, left.number, right.number);
+
+                    // A nonzero arg marks a link in a comparison chain:
+                    // the right operand stays as the next link's left.
+                    if(ins->arg) {
+                        left = right;
+                        stack.push_back(TaggedValue(result));
+                    } else {
+                        left = TaggedValue(result);
+                    }
+                    break;
+                }
+
+                static const TokenType operators[] = {
+                    TokenType::EQUALS, TokenType::NOT_EQUALS, TokenType::LESS,
+                    TokenType::LESS_OR_EQ, TokenType::MORE, TokenType::MORE_OR_EQ
+                };
+                TokenType op = operators[(int) ins->op - (int) OpCode::EQUALS];
+
+                bool result = Operations::compare(op, left, right, chunk->tokens[ins - code]);
+
+                if(ins->arg) {
+                    left = right;
+                    stack.push_back(TaggedValue(result));
+                } else {
+                    left = TaggedValue(result);
+                }
+                break;
+            }
+            case OpCode::JUMP:
+                ip = code + ins->arg;
+                heap.safepoint();
+                break;
+
+            case OpCode::JUMP_IF_FALSE:
+            {
+                bool condition = stack.back().is_true();
+                stack.pop_back();
+
+                if(!condition) {
+                    ip = code + ins->arg;
+                }
+                break;
+            }
+            case OpCode::JUMP_IF_TRUE:
+            {
+                bool condition = stack.back().is_true();
+                stack.pop_back();
+
+                if(condition) {
+                    ip = code + ins->arg;
+                }
+                break;
+            }
+            case OpCode::FOR_RANGE:
+            {
+                TaggedValue* slots = memory_block->slots.data();
+                Operations::check_range(slots[0], slots[1], slots[2], chunk->tokens[ins - code]);
+                break;
+            }
+            case OpCode::FOR_RANGE_NEXT:
+            {
+                TaggedValue* slots = memory_block->slots.data();
+
+                if(!Operations::range_continues(slots[0], slots[1], slots[2], chunk->tokens[ins - code])) {
+                    ip = code + ins->arg;
+                }
+                break;
+            }
+            case OpCode::FOR_RANGE_STEP:
+            {
+                TaggedValue* slots = memory_block->slots.data();
+
+                Operations::range_step(slots[0], slots[2], chunk->tokens[ins - code]);
+                ip = code + ins->arg;
+                heap.safepoint();
+                break;
+            }
+            case OpCode::FOR_EACH:
+            {
+                TaggedValue* slots = memory_block->slots.data();
+
+                slots[1] = Operations::iterable(slots[1], chunk->tokens[ins - code]);
+                slots[2] = TaggedValue((int64_t) 0);
+                break;
+            }
+            case OpCode::FOR_EACH_NEXT:
+            {
+                TaggedValue* slots = memory_block->slots.data();
+
+                if(slots[1].type == Type::HANDLE) {
+                    if(!((Handle*) slots[1].ref)->next(slots[0])) {
+                        ip = code + ins->arg;
+                    }
+                    break;
+                }
+
+                Array* array = (Array*) slots[1].ref;
+                int64_t position = slots[2].integer;
+
+                if(position >= (int64_t) array->length()) {
+                    ip = code + ins->arg;
+                    break;
+                }
+
+                slots[0] = array->get(position);
+                slots[2].integer = position + 1;
+                break;
+            }
+            case OpCode::ENTER_BLOCK:
+                memory_block = frame_pool.enter(chunk->scopes[ins->arg], memory_block);
+                break;
+
+            case OpCode::LEAVE_BLOCK:
+            {
+                Memory* block = memory_block;
+
+                memory_block = block->enclosing_memory_block;
+                frame_pool.leave(block);
+                break;
+            }
+
+            case OpCode::PRINT:
+                stack.back().write(output.buffer);
+                output.end_line();
+                stack.pop_back();
+                break;
+
+            case OpCode::BUILD_ARRAY:
+            {
+                std::vector<TaggedValue> elements(stack.end() - ins->arg, stack.end());
+                stack.resize(stack.size() - ins->arg);
+
+                stack.push_back(TaggedValue(heap.track(new Array(elements))));
+                break;
+            }
+            case OpCode::BUILD_MAP:
+            {
+                size_t base = stack.size() - 2 * ins->arg;
+                Token* token = chunk->tokens[ins - code];
+                Map* map = heap.track(new Map());
+
+                for(size_t i = base; i < stack.size(); i += 2) {
+                    Operations::map_insert(map, stack[i], stack[i + 1], token);
+                }
+                stack.resize(base);
+
+                stack.push_back(TaggedValue(map));
+                break;
+            }
+            case OpCode::INDEX:
+            {
+                TaggedValue index = stack.back();
+                stack.pop_back();
+                Token* token = chunk->tokens[ins - code];
+
+                stack.back() = Operations::array_get(stack.back(), index, token, token);
+                break;
+            }
+            case OpCode::STORE_INDEX:
+            {
+                TaggedValue value = stack.back();
+                stack.pop_back();
+                TaggedValue index = stack.back();
+                stack.pop_back();
+                Token* token = chunk->tokens[ins - code];
+
+                Operations::array_set(stack.back(), index, value, token, token);
+                stack.pop_back();
+                break;
+            }
+            case OpCode::DELETE_INDEX:
+            {
+                TaggedValue key = stack.back();
+                stack.pop_back();
+                Token* token = chunk->tokens[ins - code];
+
+                Operations::map_delete(stack.back(), key, token, token);
+                stack.pop_back();
+                break;
+            }
+            case OpCode::CAST:
+                stack.back() = Operations::cast(stack.back(), chunk->tokens[ins - code]);
+                break;
+
+            case OpCode::MAKE_FUNCTION:
+            {
+                Function* proto = (Function*) chunk->constants[ins->arg].ref;
+
+                stack.push_back(TaggedValue(heap.track(new Function(proto->func, proto->chunk, memory_block))));
+                break;
+            }
+            case OpCode::CALL:
+            {
+                int argc = ins->arg;
+                Token* token = chunk->tokens[ins - code];
+
+                if(call_native(argc, token)) {
+                    break;
+                }
+
+                Function* function = callee(argc, token);
+
+                if(frames.size() >= max_depth) {
+                    recursion_error(function, token, chunk);
+                }
+
+                heap.safepoint();
+                Memory* block = bind_arguments(function, argc);
+
+                frames.push_back({ chunk, ip, memory_block, block });
+
+                memory_block = block;
+                chunk = function->chunk;
+                code = chunk->code.data();
+                ip = code;
+                break;
+            }
+            case OpCode::TAIL_CALL:
+            {
+                int argc = ins->arg;
+                Token* token = chunk->tokens[ins - code];
+
+                if(call_native(argc, token)) {
+                    break;
+                }
+
+                Function* function = callee(argc, token);
+                CallFrame& frame = frames.back();
+
+                // Leave the current call's blocks as RETURN would, then
+                // reuse its CallFrame for the callee.
+                for(Memory* block = memory_block; ; block = block->enclosing_memory_block) {
+                    frame_pool.leave(block);
+
+                    if(block == frame.locals) {
+                        break;
+                    }
+                }
+                memory_block = frame.caller_block;
+
+                heap.safepoint();
+                Memory* block = bind_arguments(function, argc);
+
+                frame.locals = block;
+
+                memory_block = block;
+                chunk = function->chunk;
+                code = chunk->code.data();
+                ip = code;
+                break;
+            }
+            case OpCode::RETURN:
+            {
+                CallFrame& frame = frames.back();
+
+                // A return from inside a loop or if body skips its
+                // LEAVE_BLOCK, so leave every block up to the callee's own.
+                for(Memory* block = memory_block; ; block = block->enclosing_memory_block) {
+                    frame_pool.leave(block);
+
+                    if(block == frame.locals) {
+                        break;
+                    }
+                }
+
+                memory_block = frame.caller_block;
+                chunk = frame.chunk;
+                code = chunk->code.data();
+                ip = frame.ip;
+
+                frames.pop_back();
+                break;
+            }
+            case OpCode::IMPORT:
+            {
+                Token* path = chunk->tokens[ins - code];
+                TaggedValue object = import_module(path);
+
+                if(!object.is_empty()) {
+                    memory_block->slots[ins->arg] = object;
+                }
+                break;
+            }
+            case OpCode::OBJECT_DIVE:
+            {
+                TaggedValue parent = stack.back();
+                Token* token = chunk->tokens[ins - code];
+
+                if(parent.type == Type::MAP) {
+                    stack.back() = Operations::map_member(parent, chunk->caches[ins->arg]->name, token);
+                    break;
+                }
+
+                if(parent.type != Type::OBJECT) {
+                    std::string message = "Variable is not object type.";
+                    ValueError(token->file, token->line, token->column, message).cast();
+                }
+
+                Memory* object_memory = ((Object*) parent.ref)->object_memory;
+                int slot = chunk->caches[ins->arg]->lookup(object_memory->layout);
+
+                if(slot == -1 || object_memory->slots[slot].is_empty()) {
+                    name_error(token);
+                }
+                stack.back() = object_memory->slots[slot];
+                break;
+            }
+            case OpCode::STORE_MEMBER:
+            {
+                TaggedValue value = stack.back();
+                stack.pop_back();
+
+                Operations::member_set(stack.back(), chunk->caches[ins->arg], value, chunk->tokens[ins - code]);
+                stack.pop_back();
+                break;
+            }
+            case OpCode::MAKE_INSTANCE:
+                stack.push_back(TaggedValue(heap.track(new Object(memory_block, chunk->name))));
+                break;
+
+            case OpCode::END:
+                heap.write_barrier(memory_block);
+                return TaggedValue(heap.track(new Object(memory_block)));
+        }
+    }
+}
+
+TaggedValue VM::evaluate(std::string path) {
+    this->directory = get_dir_from_path(path);
+
+    std::string canonical_path = get_canonical_path(path);
+    module_registry.begin(canonical_path);
+
+    AST* tree = module_registry.parse(path);
+
+    Chunk* chunk = Compiler().compile(tree);
+
+    memory_block = heap.track(new Memory(((Compound*) tree)->scope, NULL));
+    TaggedValue module;
+
+    if(profiler.sampling) {
+        module_name = profiler.module_name(path);
+        module = run<true>(chunk);
+    } else {
+        module = run<false>(chunk);
+    }
+    module_registry.finish(canonical_path, module);
+
+    return module;
+}
@@ -0,0 +1,78 @@
+#ifndef VM_H
+#define VM_H
+
+#include <string>
+#include <vector>
+#include "../lexer/Lexer.h"
+#include "../parser/Parser.h"
+#include "../interpreter/Memory.h"
+#include "../interpreter/Heap.h"
+#include "../interpreter/FramePool.h"
+#include "../interpreter/ModuleRegistry.h"
+#include "../interpreter/Operations.h"
+#include "../interpreter/SemanticAnalyzer.h"
+#include "../interpreter/Profiler.h"
+#include "../compiler/Bytecode.h"
+#include "../compiler/Compiler.h"
+#include "../utils/Values.h"
+#include "../utils/Error.h"
+#include "../utils/Path.h"
+#include "../utils/StackTrace.h"
+
+// Return address of a Misty function call. The VM never recurses on the
+// C++ stack for Misty calls; it pushes one of these instead. locals is the
+// callee's own Memory, so RETURN knows which blocks it leaves.
+struct CallFrame {
+    Chunk* chunk;
+    Instruction* ip;
+    Memory* caller_block;
+    Memory* locals;
+};
+
+class VM : public RootSet {
+    public:
+        VM();
+        ~VM();
+
+        TaggedValue evaluate(std::string path);
+
+        Memory* memory_block;
+
+        std::string directory;
+
+        // Deepest Misty call stack allowed before a RecursionError. Frames
+        // live in a growable vector, so this only bounds memory use.
+        inline static size_t max_depth = 10000000;
+
+    private:
+        std::vector<TaggedValue> stack;
+        std::vector<CallFrame> frames;
+
+        // The module's name in profiles, when profiling.
+        const std::string* module_name;
+
+        void trace_roots(Heap* heap) override;
+
+        // Only the profiling copy of the loop looks for pending samples.
+        template<bool profiling>
+        TaggedValue run(Chunk* chunk);
+
+        void sample(Chunk* chunk, Token* token);
+
+        TaggedValue import_module(Token* path);
+
+        // Checks the function and argument count of a call whose callee and
+        // arguments are on top of the stack, then pops them into a new frame.
+        Function* callee(int argc, Token* token);
+        Memory* bind_arguments(Function* function, int argc);
+
+        // Runs the call in place if the callee is a NativeFunction, leaving
+        // its result where the callee was. Returns false otherwise.
+        bool call_native(int argc, Token* token);
+
+        void name_error(Token* token);
+        void call_error(Token* token, std::string message);
+        void recursion_error(Function* function, Token* token, Chunk* chunk);
+};
+
+#endif